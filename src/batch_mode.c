@@ -6,6 +6,7 @@
  * @date 12.06.2020
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -13,6 +14,7 @@
 #include "gamma.h"
 #include "batch_mode.h"
 #include "input_interface.h"
+#include "stringology.h"
 #include "isnull.h"
 
 
@@ -22,7 +24,14 @@ enum function_signature {
     move_function, /**< Funkcja wykonuje ruch, zwraca wartość bool. */
     fields_function, /**< Funkcja zlicza pola, zwraca wartość uint32_t. */
     check_function, /**< Funckja dokonuje sprawdzenia, zwraca wartość bool. */
-    string_function /**< Funkcja zwraca opis planszy (char *). */
+    string_function, /**< Funkcja zwraca opis planszy (char *), którego nie
+                      * zwalnia wywołujący. */
+    region_function, /**< Funkcja wypisuje fragment planszy, zwraca wartość
+                      * bool. */
+    snapshot_function, /**< Funkcja zapisuje lub wczytuje migawkę gry (może
+                        * zastąpić grę), zwraca wartość bool. */
+    declare_function /**< Funkcja zastępuje grę nową grą, zwraca wartość
+                      * bool. */
 };
 
 
@@ -32,7 +41,10 @@ union function_type {
     bool (*move_function)(gamma_t *, uint32_t, uint32_t, uint32_t); /**< Funkcja wykonuje ruch, zwraca wartość bool. */
     uint64_t (*fields_function)(gamma_t *, uint32_t); /**< Funkcja zlicza pola, zwraca wartość uint32_t. */
     bool (*check_function)(gamma_t *, uint32_t); /**< Funckja dokonuje sprawdzenia, zwraca wartość bool. */
-    char *(*string_function)(gamma_t *); /**< Funkcja zwraca opis planszy (char *). */
+    char *(*string_function)(gamma_t *); /**< Funkcja zwraca opis planszy (char *), którego nie zwalnia wywołujący. */
+    bool (*region_function)(gamma_t *, uint32_t, uint32_t, uint32_t, uint32_t); /**< Funkcja wypisuje fragment planszy, zwraca wartość bool. */
+    bool (*snapshot_function)(gamma_t **, uint32_t); /**< Funkcja zapisuje lub wczytuje migawkę gry, zwraca wartość bool. */
+    bool (*declare_function)(gamma_t **, uint32_t, uint32_t, uint32_t, uint32_t); /**< Funkcja zastępuje grę nową grą, zwraca wartość bool. */
 };
 
 
@@ -62,6 +74,176 @@ struct batch_command {
     }
 
 
+/** Największy rozmiar opisu planszy przechowywanego między poleceniami `p`.
+ * Większe plansze wypisywane są porcjami bez przechowywania opisu.
+ */
+#define BOARD_BUFFER_LIMIT ((uint64_t) 1 << 26)
+
+
+/** Wzorzec nazwy pliku migawki gry o podanym numerze. */
+#define SNAPSHOT_NAME "gamma%" PRIu32 ".snapshot"
+
+
+/** Maksymalna długość nazwy pliku migawki gry. */
+#define SNAPSHOT_NAME_SIZE 32
+
+
+/** Maksymalna liczba parametrów polecenia. */
+#define BATCH_PARAMS_SIZE 4
+
+
+/** Liczba zakończonych gier przechowywanych do ponownego użycia. */
+#define BATCH_POOL_SIZE 4
+
+
+/** Opis planszy wypisywany poleceniem `p`, poprawiany między kolejnymi
+ * poleceniami jedynie w zmienionych polach.
+ */
+static char *board_buffer = NULL;
+
+
+/** Rozmiar bufora @ref board_buffer. */
+static size_t board_buffer_size = 0;
+
+
+/** Zakończone gry, których pamięć wykorzystywana jest przez kolejne gry
+ * o tych samych wymiarach planszy i liczbie graczy.
+ */
+static gamma_pool_t *engines = NULL;
+
+
+/** @brief Opis planszy dla polecenia `p`.
+ * Pierwsze wywołanie tworzy opis funkcją @ref gamma_board, kolejne
+ * poprawiają go funkcją @ref gamma_board_update. Opis dużej planszy
+ * wypisywany jest od razu funkcją @ref gamma_board_fwrite.
+ * @param[in, out] g            – wskaźnik na strukturę silnika gry.
+ * @return Wskaźnik na opis planszy lub `NULL`, jeżeli nie udało się go
+ * utworzyć lub został już wypisany.
+ */
+static char *batch_board(gamma_t *g) {
+    uint64_t size = ((uint64_t) uint64_length(gamma_players(g))
+                     * gamma_width(g) + 1) * gamma_height(g) + 1;
+    if (size > BOARD_BUFFER_LIMIT) {
+        gamma_board_fwrite(g, stdout, 0, 0, gamma_width(g), gamma_height(g));
+        return NULL;
+    }
+    if (ISNULL(board_buffer)) {
+        board_buffer = gamma_board(g);
+        board_buffer_size = ISNULL(board_buffer) ? 0
+                                                 : strlen(board_buffer) + 1;
+        return board_buffer;
+    }
+    return gamma_board_update(g, board_buffer, board_buffer_size)
+           ? board_buffer : NULL;
+}
+
+
+/** @brief Wypisanie fragmentu planszy dla polecenia `r`.
+ * @param[in, out] g            – wskaźnik na strukturę silnika gry,
+ * @param[in] x                 – numer pierwszej kolumny,
+ * @param[in] y                 – numer pierwszego (dolnego) wiersza,
+ * @param[in] width             – liczba kolumn,
+ * @param[in] height            – liczba wierszy.
+ * @return Wartość @p true jeżeli udało się wypisać fragment planszy.
+ */
+static bool batch_region(gamma_t *g, uint32_t x, uint32_t y, uint32_t width,
+                         uint32_t height) {
+    return gamma_board_fwrite(g, stdout, x, y, width, height);
+}
+
+
+/** @brief Otwarcie pliku migawki gry.
+ * @param[in] slot              – numer migawki,
+ * @param[in] mode              – tryb otwarcia pliku (jak w `fopen`).
+ * @return Strumień pliku lub `NULL`, jeżeli nie udało się go otworzyć.
+ */
+static FILE *batch_snapshot_open(uint32_t slot, const char *mode) {
+    char name[SNAPSHOT_NAME_SIZE];
+    snprintf(name, sizeof(name), SNAPSHOT_NAME, slot);
+    return fopen(name, mode);
+}
+
+
+gamma_t *batch_snapshot_load(uint32_t slot) {
+    FILE *stream = batch_snapshot_open(slot, "rb");
+    if (ISNULL(stream)) {
+        return NULL;
+    }
+    gamma_t *g = gamma_load(stream, NULL);
+    fclose(stream);
+    return g;
+}
+
+
+/** @brief Zapisanie migawki gry dla polecenia `s`.
+ * @param[in] g                 – wskaźnik na wskaźnik na strukturę silnika
+ *                                gry,
+ * @param[in] slot              – numer migawki.
+ * @return Wartość @p true jeżeli udało się zapisać migawkę.
+ */
+static bool batch_save(gamma_t **g, uint32_t slot) {
+    FILE *stream = batch_snapshot_open(slot, "wb");
+    if (ISNULL(stream)) {
+        return false;
+    }
+    bool result = gamma_save(*g, stream);
+    return fclose(stream) == 0 && result;
+}
+
+
+/** @brief Wczytanie migawki gry dla polecenia `l`.
+ * Wczytana gra zastępuje bieżącą. Jeżeli nie uda się jej wczytać, bieżąca
+ * gra pozostaje bez zmian.
+ * @param[in, out] g            – wskaźnik na wskaźnik na strukturę silnika
+ *                                gry,
+ * @param[in] slot              – numer migawki.
+ * @return Wartość @p true jeżeli udało się wczytać migawkę.
+ */
+static bool batch_load(gamma_t **g, uint32_t slot) {
+    gamma_t *loaded = batch_snapshot_load(slot);
+    if (ISNULL(loaded)) {
+        return false;
+    }
+    gamma_delete(*g);
+    *g = loaded;
+    /* Opis planszy dotyczył poprzedniej gry. */
+    free(board_buffer);
+    board_buffer = NULL;
+    board_buffer_size = 0;
+    return true;
+}
+
+
+/** @brief Rozpoczęcie nowej gry dla polecenia `B`.
+ * Nowa gra zastępuje bieżącą, która trafia do puli @ref engines. Jeżeli nie
+ * uda się utworzyć nowej gry, bieżąca gra pozostaje bez zmian.
+ * @param[in, out] g            – wskaźnik na wskaźnik na strukturę silnika
+ *                                gry,
+ * @param[in] width             – szerokość planszy,
+ * @param[in] height            – wysokość planszy,
+ * @param[in] players           – liczba graczy,
+ * @param[in] areas             – maksymalna liczba obszarów gracza.
+ * @return Wartość @p true jeżeli udało się utworzyć nową grę.
+ */
+static bool batch_declare(gamma_t **g, uint32_t width, uint32_t height,
+                          uint32_t players, uint32_t areas) {
+    if (ISNULL(engines)) {
+        engines = gamma_pool_new(BATCH_POOL_SIZE);
+    }
+    gamma_t *declared = gamma_pool_get(engines, width, height, players, areas);
+    if (ISNULL(declared)) {
+        return false;
+    }
+    gamma_pool_put(engines, *g);
+    *g = declared;
+    /* Opis planszy dotyczył poprzedniej gry. */
+    free(board_buffer);
+    board_buffer = NULL;
+    board_buffer_size = 0;
+    return true;
+}
+
+
 /** Polecenia dostępne w trybie wsadowym.
  */
 static const struct batch_command commands[] = {
@@ -70,7 +252,11 @@ static const struct batch_command commands[] = {
         BATCH_COMMAND('b', 1, fields_function, gamma_busy_fields),
         BATCH_COMMAND('f', 1, fields_function, gamma_free_fields),
         BATCH_COMMAND('q', 1, check_function, gamma_golden_possible),
-        BATCH_COMMAND('p', 0, string_function, gamma_board)
+        BATCH_COMMAND('p', 0, string_function, batch_board),
+        BATCH_COMMAND('r', 4, region_function, batch_region),
+        BATCH_COMMAND('s', 1, snapshot_function, batch_save),
+        BATCH_COMMAND('l', 1, snapshot_function, batch_load),
+        BATCH_COMMAND('B', 4, declare_function, batch_declare)
 };
 
 
@@ -91,13 +277,16 @@ static const struct batch_command *batch_command_select(char command) {
 
 
 /** @brief Wykonanie polecenia w trybie wsadowym.
- * @param[in, out] g            – wskaźnik na strukturę silnika gry,
+ * @param[in, out] engine       – wskaźnik na wskaźnik na strukturę silnika
+ *                                gry,
  * @param[in] command           – wskaźnik na strukturę polecenia do wykonania,
  * @param[in] param_size        – liczba przekazanych w poleceniu parametrów,
  * @param[in] params            – liczbowe parametry polecenia.
  */
-static void batch_command_run(gamma_t *g, const struct batch_command *command,
+static void batch_command_run(gamma_t **engine,
+                              const struct batch_command *command,
                               int param_size, const uint32_t params[param_size]) {
+    gamma_t *g = *engine;
     if (ISNULL(g) || ISNULL(params) || ISNULL(command)
         || command->param_size != param_size) {
         report_error();
@@ -117,8 +306,26 @@ static void batch_command_run(gamma_t *g, const struct batch_command *command,
             break;
         case string_function:
             string = command->fun.string_function(g);
-            printf("%s", string);
-            free(string);
+            if (!ISNULL(string)) {
+                printf("%s", string);
+            }
+            break;
+        case region_function:
+            if (!command->fun.region_function(g, params[0], params[1],
+                                              params[2], params[3])) {
+                report_error();
+            }
+            break;
+        case snapshot_function:
+            printf("%d\n", command->fun.snapshot_function(engine, params[0]));
+            break;
+        case declare_function:
+            if (command->fun.declare_function(engine, params[0], params[1],
+                                              params[2], params[3])) {
+                report_ok();
+            } else {
+                report_error();
+            }
             break;
         default:
             break;
@@ -126,16 +333,18 @@ static void batch_command_run(gamma_t *g, const struct batch_command *command,
 }
 
 
-void batch_run(gamma_t *g) {
-    if (ISNULL(g)) {
+void batch_run(gamma_t **g) {
+    if (ISNULL(g) || ISNULL(*g)) {
         return;
     }
-    uint32_t param[3];
+    uint32_t param[BATCH_PARAMS_SIZE];
     char cmd;
     int resp;
     while (true) {
-        resp = parse_line(&cmd, 3, param);
+        resp = parse_line(&cmd, BATCH_PARAMS_SIZE, param);
         if (resp == PARSE_END) {
+            free(board_buffer);
+            gamma_pool_delete(engines);
             exit(EXIT_SUCCESS);
         } else if (resp != PARSE_ERROR && resp != PARSE_CONTINUE) {
             const struct batch_command *command = batch_command_select(cmd);
@@ -8,16 +8,30 @@
 #ifndef BATCHMODE_H
 #define BATCHMODE_H
 
+#include <stdint.h>
+
 
 /** Struktura przechowująca stan gry.
  */
 typedef struct gamma gamma_t;
 
 
+/** @brief Wczytanie migawki gry o podanym numerze.
+ * Migawka jest wczytywana z pliku `gamma<slot>.snapshot` w bieżącym katalogu.
+ * @param[in] slot              – numer migawki.
+ * @return Wskaźnik na strukturę wczytanej gry lub `NULL`, jeżeli nie udało się
+ * jej wczytać.
+ */
+gamma_t *batch_snapshot_load(uint32_t slot);
+
+
 /** @brief Uruchomienie i przejście do trybu wsadowego.
- * @param[in, out] g            – wskaźnik na strukturę silnika gry Gamma.
+ * Polecenie `l` może zastąpić grę wskazywaną przez @p g grą wczytaną
+ * z migawki, a polecenie `B width height players areas` – nową grą.
+ * @param[in, out] g            – wskaźnik na wskaźnik na strukturę silnika gry
+ *                                Gamma.
  */
-void batch_run(gamma_t *g);
+void batch_run(gamma_t **g);
 
 
 #endif /* BATCHMODE_H */
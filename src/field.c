@@ -1,253 +1,2387 @@
 /** @file
- * Implementacja struktury pola na planszy gry Gamma.
+ * Implementacja planszy gry Gamma.
  *
  * @author Adam Rozenek <adam.rozenek@students.mimuw.edu.pl>
  * @date 12.06.2020
  */
 
+/** Makro udostępniające funkcje `pread` i `ftruncate`.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "field.h"
 #include "isnull.h"
 
 
-/** Struktura przechowująca informacje o polu planszy.
- */
-typedef struct field {
-    struct field *adjoining[ADJOINING_FIELDS]; /**< Tablica wszystkich
-                                                * sąsiadujących pól. */
-    uint32_t size_adjoining; /**< Ilość sąsiadujących pól. */
-    field_t *next_node; /**< Pomocnicze pole do zorganizowania pól w kolejkę. */
-    /** Struktura reprezentująca obszar pól.
-     * Obszar zaimplementowany jest jako struktura zbiorów rozłącznych w postaci
-     * kolejki cyklicznej.
-     */
-    struct area {
-        struct area *next; /**< Następne pole należące do obszaru. */
-        struct area *prev; /**< Poprzednie pole należące do obszaru. */
-        struct area *repr; /**< Wskaźnik na reprezentanta obszaru. */
-        uint64_t size; /**< Rozmiar obszaru (jeżeli pole jest reprezentantem).*/
-    } area; /**< Obszar do którego należy pole. */
-    uint32_t owner; /**< Identyfikator właściciela pola. */
-    bool visited; /**< Informacja o tym czy odwiedzono pole algorytmem BFS. */
-} field_t;
-
-
-field_t *field_at_board(field_t *b, uint64_t field_id) {
-    return !ISNULL(b) ? &b[field_id] : NULL;
-}
-
-
-/** @brief Inicjacja pola.
- * @param[out] fields       – wskaźnik na tablicę pól do zainicjowania,
- *                            która ma reprezentować planszę,
- * @param[in] x             – numer kolumny pola do zainicjowania,
- *                            liczba nieujemna mniejsza od @p max_x,
- * @param[in] y             – numer wiersza pola do zainicjowania,
- *                            liczba nieujemna mniejsza od @p max_y,
- * @param[in] max_x         – liczba kolumn na planszy,
- * @param[in] max_y         – liczba wierszy na planszy
- */
-static void field_init(field_t *fields, uint32_t x, uint32_t y,
-                       uint32_t max_x, uint32_t max_y) {
-    if (ISNULL(fields) || x >= max_x || y >= max_y) {
-        return;
+/** Liczba bitów w słowie bitmapy odwiedzonych pól. */
+#define WORD_BITS 64
+
+
+/** Minimalna pojemność tablic pomocniczych planszy. */
+#define INITIAL_CAPACITY 16
+
+
+/** Logarytm dwójkowy boku fragmentu planszy w trybie rzadkim. */
+#define TILE_SHIFT 6
+
+
+/** Bok fragmentu planszy w trybie rzadkim. */
+#define TILE_SIDE (1u << TILE_SHIFT)
+
+
+/** Maska numeru pola we fragmencie planszy (dla jednej współrzędnej). */
+#define TILE_MASK (TILE_SIDE - 1)
+
+
+/** Liczba pól we fragmencie planszy w trybie rzadkim. */
+#define TILE_FIELDS ((uint64_t) TILE_SIDE * TILE_SIDE)
+
+
+/** Logarytm dwójkowy boku kwadratu pól w układzie kwadratowym. */
+#define SQUARE_SHIFT 3
+
+
+/** Bok kwadratu pól w układzie kwadratowym. */
+#define SQUARE_SIDE (1u << SQUARE_SHIFT)
+
+
+/** Maska numeru pola w kwadracie (dla jednej współrzędnej). */
+#define SQUARE_MASK (SQUARE_SIDE - 1)
+
+
+/** Największy bok planszy w trybie bitowym (liczba bitów w wierszu). */
+#define BITS_SIDE 64
+
+
+/** Największa liczba graczy planszy w trybie bitowym. */
+#define BITS_PLAYERS 64
+
+
+/** Liczba pól, od której plansza domyślnie tworzona jest w trybie rzadkim. */
+#define SPARSE_THRESHOLD ((uint64_t) 1 << 26)
+
+
+/** Sygnatura pliku planszy (napis `GAMMABD1`). */
+#define FILE_MAGIC UINT64_C(0x314442414d4d4147)
+
+
+/** Wyrównanie danych użytkownika zapisywanych w pliku planszy. */
+#define FILE_ALIGN 64
+
+
+/** Zapas identyfikatorów obszarów w pliku planszy ponad liczbę pól: tyle
+ * identyfikatorów mogą jednocześnie zajmować części dzielonego obszaru
+ * oraz rezerwa @ref field_reserve. */
+#define FILE_AREAS_MARGIN (4 * (ADJOINING_FIELDS + 1))
+
+
+/** @brief Numer kolumny pola.
+ * @param[in] field         – identyfikator pola.
+ */
+#define FIELD_X(field) ((uint32_t) (field))
+
+
+/** @brief Numer wiersza pola.
+ * @param[in] field         – identyfikator pola.
+ */
+#define FIELD_Y(field) ((uint32_t) ((field) >> 32))
+
+
+/** Struktura opisująca obszar pól jednego gracza.
+ */
+struct area {
+    uint64_t size; /**< Liczba pól w obszarze. */
+    uint32_t next_free; /**< Następny nieużywany identyfikator obszaru. */
+    bool stale; /**< Informacja o tym czy obszar zmienił się od ostatniego
+                 * wyznaczenia punktów artykulacji jego pól. */
+};
+
+
+/** Nagłówek pliku planszy.
+ * Plik zawiera kolejno: nagłówek, dane użytkownika, tablice pól w układzie
+ * trybu gęstego (od początku strony) i tablicę obszarów. Liczniki planszy
+ * zapisywane są w nagłówku przy jej zamknięciu.
+ */
+struct board_file {
+    uint64_t magic; /**< Sygnatura @ref FILE_MAGIC. */
+    uint32_t width; /**< Liczba kolumn. */
+    uint32_t height; /**< Liczba wierszy. */
+    uint32_t players; /**< Liczba graczy. */
+    uint32_t closed; /**< Niezerowa, jeżeli plik został poprawnie zamknięty. */
+    uint32_t tiled; /**< Niezerowa, jeżeli pola ułożone są w kwadratach. */
+    uint64_t extra_size; /**< Rozmiar danych użytkownika. */
+    uint64_t occupied; /**< Liczba zajętych pól. */
+    uint32_t areas_used; /**< Liczba kiedykolwiek użytych identyfikatorów. */
+    uint32_t free_area; /**< Pierwszy nieużywany identyfikator lub `0`. */
+    uint32_t dfs_clock; /**< Ostatnio nadany numer odwiedzenia. */
+};
+
+
+/** Prostokąt fragmentów planszy w trybie rzadkim zawierający wszystkie pola
+ * obszaru. Może być większy niż potrzeba: części podzielonego obszaru
+ * dziedziczą jego prostokąt.
+ */
+struct area_box {
+    uint32_t left; /**< Pierwsza kolumna fragmentów. */
+    uint32_t bottom; /**< Pierwszy wiersz fragmentów. */
+    uint32_t right; /**< Ostatnia kolumna fragmentów. */
+    uint32_t top; /**< Ostatni wiersz fragmentów. */
+};
+
+
+/** Ramka stosu iteracyjnego przeszukiwania w głąb obszaru.
+ */
+struct dfs_frame {
+    field_t field; /**< Identyfikator odwiedzanego pola. */
+    uint32_t low; /**< Najmniejszy numer odwiedzenia osiągalny z poddrzewa. */
+    uint32_t next; /**< Numer następnego sąsiada do rozpatrzenia. */
+};
+
+
+/** Poprzedni stan pola zapisany w dzienniku zmian planszy.
+ */
+struct journal_cell {
+    field_t field; /**< Identyfikator pola. */
+    uint32_t area; /**< Identyfikator obszaru pola przed zapisem. */
+    uint32_t owner; /**< Właściciel pola przed zapisem. */
+};
+
+
+/** Poprzedni stan obszaru zapisany w dzienniku zmian planszy.
+ */
+struct journal_area {
+    uint32_t id; /**< Identyfikator obszaru. */
+    struct area area; /**< Opis obszaru przed zmianą. */
+    struct area_box box; /**< Prostokąt obszaru przed zmianą (tylko w trybie
+                          * rzadkim). */
+};
+
+
+/** Początek zmiany w dzienniku planszy wraz z licznikami planszy sprzed niej.
+ */
+struct journal_change {
+    uint64_t cells; /**< Liczba zapisanych pól przed zmianą. */
+    uint64_t areas; /**< Liczba zapisanych obszarów przed zmianą. */
+    uint64_t occupied; /**< Liczba zajętych pól. */
+    uint32_t areas_used; /**< Liczba kiedykolwiek użytych identyfikatorów. */
+    uint32_t free_area; /**< Pierwszy nieużywany identyfikator lub `0`. */
+};
+
+
+/** Dziennik zmian planszy.
+ * Przed każdym zapisem pola lub obszaru w trakcie zmiany zapamiętywany jest
+ * jego poprzedni stan, więc cofnięcie zmiany odtwarza planszę w czasie
+ * proporcjonalnym do liczby zapisów. Punkty artykulacji nie są zapisywane –
+ * odtworzone obszary oznaczane są jako zmienione.
+ */
+struct journal {
+    bool enabled; /**< Informacja o tym czy zmiany są zapisywane. */
+    bool open; /**< Informacja o tym czy zapisy pól i obszarów dopisywane
+                * są do ostatniej zmiany. */
+    struct journal_change *changes; /**< Zapisane zmiany. */
+    uint64_t changes_size; /**< Liczba zapisanych zmian. */
+    uint64_t changes_capacity; /**< Rozmiar tablicy zmian. */
+    struct journal_cell *cells; /**< Zapisane pola. */
+    uint64_t cells_size; /**< Liczba zapisanych pól. */
+    uint64_t cells_capacity; /**< Rozmiar tablicy pól. */
+    struct journal_area *areas; /**< Zapisane obszary. */
+    uint64_t areas_size; /**< Liczba zapisanych obszarów. */
+    uint64_t areas_capacity; /**< Rozmiar tablicy obszarów. */
+};
+
+
+/** Fragment planszy: tablice opisujące pola należące do fragmentu.
+ * W trybie gęstym cała plansza jest jednym fragmentem, a pola ułożone są
+ * w porządku wierszowym. W trybie rzadkim plansza dzielona jest na
+ * kwadratowe fragmenty o boku @ref TILE_SIDE, tworzone dopiero przy zajęciu
+ * pierwszego pola; brakujący fragment oznacza same wolne pola.
+ */
+struct tile {
+    void *owner; /**< Identyfikatory właścicieli pól. */
+    uint32_t *area; /**< Identyfikatory obszarów pól. */
+    uint64_t *visited; /**< Bitmapa pól odwiedzonych algorytmem BFS. */
+    uint8_t *pieces; /**< Liczba części, na które rozpadnie się obszar pola
+                      * po jego zwolnieniu (aktualna dla obszarów, które nie
+                      * zmieniły się od jej wyznaczenia). */
+    uint32_t *order; /**< Numery odwiedzenia pól przeszukiwaniem w głąb. */
+    atomic_uint refs; /**< Liczba plansz korzystających z fragmentu w trybie
+                       * rzadkim. Fragment współdzielony przez kopie planszy
+                       * jest tylko do odczytu. */
+};
+
+
+/** Położenie pola w pamięci planszy.
+ */
+struct cell {
+    struct tile *tile; /**< Fragment planszy lub `NULL` jeżeli nie istnieje. */
+    uint64_t index; /**< Numer pola we fragmencie. */
+};
+
+
+/** Struktura przechowująca planszę.
+ * Właściciele pól i przynależność do obszarów trzymane są w płaskich
+ * tablicach fragmentów planszy (@ref tile). Szerokość identyfikatora
+ * właściciela (1, 2 lub 4 bajty) dobierana jest do liczby graczy przy
+ * tworzeniu planszy. Obszary opisane są osobno w tablicy @ref area,
+ * indeksowanej identyfikatorem obszaru (identyfikator `0` oznacza brak
+ * obszaru).
+ */
+struct board {
+    uint32_t width; /**< Liczba kolumn. */
+    uint32_t height; /**< Liczba wierszy. */
+    uint32_t players; /**< Liczba graczy. */
+    uint32_t owner_size; /**< Rozmiar identyfikatora właściciela w bajtach. */
+    bool sparse; /**< Informacja o tym czy plansza jest w trybie rzadkim. */
+    bool tiled; /**< Informacja o tym czy pola ułożone są w kwadratach
+                 * (@ref BOARD_LAYOUT_SQUARES). */
+    uint64_t stride; /**< Liczba pól tablic na jeden wiersz planszy w trybie
+                      * gęstym. */
+    uint32_t tiles_x; /**< Liczba fragmentów w wierszu planszy. */
+    uint64_t tiles_count; /**< Liczba fragmentów planszy. */
+    struct tile **tiles; /**< Tablica fragmentów planszy. */
+    uint64_t *used; /**< Numery utworzonych fragmentów planszy w trybie
+                     * rzadkim. */
+    uint64_t used_size; /**< Liczba utworzonych fragmentów. */
+    uint64_t used_capacity; /**< Rozmiar tablicy @ref used. */
+    uint64_t *shared_map; /**< Bitmapa fragmentów, które mogą być
+                           * współdzielone z kopią planszy, lub `NULL`, jeżeli
+                           * planszy nie kopiowano. */
+    uint64_t shared; /**< Liczba fragmentów oznaczonych w @ref shared_map. */
+    struct tile dense; /**< Jedyny fragment planszy w trybie gęstym. */
+    struct tile *dense_tile; /**< Wskaźnik na @ref dense. */
+    uint64_t dense_size; /**< Rozmiar pamięci tablic w trybie gęstym. */
+    bool bitboard; /**< Informacja o tym czy plansza jest w trybie bitowym
+                    * (@ref BOARD_STORAGE_BITS). */
+    uint64_t *bits; /**< Bitmapy pól graczy w trybie bitowym lub `NULL`:
+                     * wiersz `y` gracza `p` to
+                     * `bits[(p - 1) * height + y]`,
+                     * a bit `x` wiersza odpowiada kolumnie `x`. */
+    struct board_file *file; /**< Początek zmapowanego pliku planszy lub
+                              * `NULL`, jeżeli plansza jest w pamięci. */
+    uint64_t file_size; /**< Rozmiar pliku planszy. */
+    bool file_private; /**< Informacja o tym czy plik planszy zmapowany jest
+                        * prywatnie, tylko do odczytu (zmiany planszy nie
+                        * trafiają do pliku). */
+    bool separate; /**< Informacja o tym czy struktura planszy została
+                    * przydzielona osobno, a nie w bloku podanym
+                    * w @ref field_board_init. */
+    uint32_t dfs_clock; /**< Ostatnio nadany numer odwiedzenia. */
+    struct dfs_frame *dfs; /**< Stos przeszukiwania w głąb. */
+    uint64_t dfs_capacity; /**< Rozmiar stosu przeszukiwania w głąb. */
+    struct area *areas; /**< Tablica obszarów. */
+    uint32_t areas_capacity; /**< Rozmiar tablicy obszarów. */
+    struct area_box *boxes; /**< Prostokąty obszarów w trybie rzadkim,
+                             * indeksowane identyfikatorem obszaru. */
+    uint32_t boxes_capacity; /**< Rozmiar tablicy prostokątów. */
+    uint32_t areas_used; /**< Liczba kiedykolwiek użytych identyfikatorów. */
+    uint32_t free_area; /**< Pierwszy nieużywany identyfikator lub `0`. */
+    field_t *queue; /**< Kolejka algorytmu BFS. */
+    uint64_t queue_capacity; /**< Rozmiar kolejki. */
+    uint64_t occupied; /**< Liczba zajętych pól. */
+    struct journal journal; /**< Dziennik zmian planszy. */
+};
+
+
+/** @brief Numer pola w układzie kwadratowym.
+ * Pasy @ref SQUARE_SIDE kolejnych wierszy ułożone są jeden po drugim, w pasie
+ * kolejne kwadraty, a w kwadracie kolejne wiersze kwadratu.
+ * @param[in] x             – numer kolumny,
+ * @param[in] y             – numer wiersza,
+ * @param[in] stride        – szerokość tablicy, wielokrotność
+ *                            @ref SQUARE_SIDE,
+ * @param[in] band          – liczba wierszy pasa zawierającego pole
+ *                            (mniejsza od @ref SQUARE_SIDE tylko w ostatnim
+ *                            pasie).
+ * @return Numer pola w tablicy.
+ */
+static inline uint64_t field_square_index(uint32_t x, uint32_t y,
+                                          uint64_t stride, uint32_t band) {
+    return (uint64_t) (y & ~SQUARE_MASK) * stride
+           + (uint64_t) (x & ~SQUARE_MASK) * band
+           + ((y & SQUARE_MASK) << SQUARE_SHIFT) + (x & SQUARE_MASK);
+}
+
+
+/** @brief Numer fragmentu planszy w trybie rzadkim zawierającego pole.
+ * @param[in] b             – wskaźnik na planszę w trybie rzadkim,
+ * @param[in] field         – identyfikator pola.
+ * @return Numer fragmentu w tablicy fragmentów planszy.
+ */
+static inline uint64_t field_tile_index(const board_t *b, field_t field) {
+    return (uint64_t) (FIELD_Y(field) >> TILE_SHIFT) * b->tiles_x
+           + (FIELD_X(field) >> TILE_SHIFT);
+}
+
+
+/** @brief Położenie pola w pamięci planszy.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola.
+ * @return Fragment planszy zawierający pole i numer pola w tym fragmencie.
+ */
+static inline struct cell field_cell(const board_t *b, field_t field) {
+    uint32_t x = FIELD_X(field), y = FIELD_Y(field);
+    if (!b->sparse) {
+        if (!b->tiled) {
+            return (struct cell) { .tile = b->tiles[0],
+                                   .index = b->stride * y + x };
+        }
+        uint32_t band = b->height - (y & ~SQUARE_MASK);
+        band = band < SQUARE_SIDE ? band : SQUARE_SIDE;
+        return (struct cell) { .tile = b->tiles[0],
+                               .index = field_square_index(x, y, b->stride,
+                                                           band) };
+    }
+    uint64_t tile = field_tile_index(b, field);
+    uint64_t index = b->tiled ? field_square_index(x & TILE_MASK, y & TILE_MASK,
+                                                   TILE_SIDE, SQUARE_SIDE)
+                              : ((y & TILE_MASK) << TILE_SHIFT)
+                                | (x & TILE_MASK);
+    return (struct cell) { .tile = b->tiles[tile], .index = index };
+}
+
+
+/** @brief Odczytanie właściciela pola.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] c             – położenie pola.
+ * @return Identyfikator właściciela pola lub `0` jeżeli pole jest wolne.
+ */
+static inline uint32_t owner_get(const board_t *b, struct cell c) {
+    if (ISNULL(c.tile)) {
+        return 0;
+    }
+    switch (b->owner_size) {
+        case sizeof(uint8_t):
+            return ((const uint8_t *) c.tile->owner)[c.index];
+        case sizeof(uint16_t):
+            return ((const uint16_t *) c.tile->owner)[c.index];
+        default:
+            return ((const uint32_t *) c.tile->owner)[c.index];
+    }
+}
+
+
+/** @brief Zapisanie właściciela pola.
+ * Fragment planszy zawierający pole musi istnieć.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] c             – położenie pola,
+ * @param[in] owner         – identyfikator właściciela lub `0`.
+ */
+static inline void owner_set(const board_t *b, struct cell c, uint32_t owner) {
+    switch (b->owner_size) {
+        case sizeof(uint8_t):
+            ((uint8_t *) c.tile->owner)[c.index] = (uint8_t) owner;
+            break;
+        case sizeof(uint16_t):
+            ((uint16_t *) c.tile->owner)[c.index] = (uint16_t) owner;
+            break;
+        default:
+            ((uint32_t *) c.tile->owner)[c.index] = owner;
+            break;
+    }
+}
+
+
+/** @brief Identyfikator obszaru zajętego pola.
+ * @param[in] c             – położenie pola.
+ * @return Wskaźnik na identyfikator obszaru pola.
+ */
+static inline uint32_t *cell_area(struct cell c) {
+    return &c.tile->area[c.index];
+}
+
+
+/** @brief Liczba części obszaru po zwolnieniu zajętego pola.
+ * @param[in] c             – położenie pola.
+ * @return Wskaźnik na liczbę części.
+ */
+static inline uint8_t *cell_pieces(struct cell c) {
+    return &c.tile->pieces[c.index];
+}
+
+
+/** @brief Numer odwiedzenia zajętego pola przeszukiwaniem w głąb.
+ * @param[in] c             – położenie pola.
+ * @return Wskaźnik na numer odwiedzenia.
+ */
+static inline uint32_t *cell_order(struct cell c) {
+    return &c.tile->order[c.index];
+}
+
+
+/** @brief Sprawdzenie czy zajęte pole zostało odwiedzone.
+ * @param[in] c             – położenie pola.
+ * @return Wartość @p true jeżeli pole jest oznaczone jako odwiedzone.
+ */
+static inline bool cell_visited(struct cell c) {
+    return (c.tile->visited[c.index / WORD_BITS] >> (c.index % WORD_BITS)) & 1;
+}
+
+
+/** @brief Zmiana oznaczenia odwiedzenia zajętego pola.
+ * @param[in] c             – położenie pola.
+ */
+static inline void cell_toggle_visited(struct cell c) {
+    c.tile->visited[c.index / WORD_BITS] ^= (uint64_t) 1 << (c.index % WORD_BITS);
+}
+
+
+field_t field_at(uint32_t x, uint32_t y) {
+    return ((uint64_t) y << 32) | x;
+}
+
+
+uint32_t field_column(field_t field) {
+    return FIELD_X(field);
+}
+
+
+uint32_t field_row(field_t field) {
+    return FIELD_Y(field);
+}
+
+
+/** @brief Przypisanie tablic fragmentu planszy do bloku pamięci.
+ * @param[out] t            – fragment planszy,
+ * @param[in] memory        – wyzerowany blok pamięci o rozmiarze co najmniej
+ *                            @ref field_tile_size,
+ * @param[in] n_fields      – liczba pól fragmentu, wielokrotność
+ *                            @ref WORD_BITS,
+ * @param[in] owner_size    – rozmiar identyfikatora właściciela w bajtach.
+ */
+static void field_tile_init(struct tile *t, void *memory, uint64_t n_fields,
+                            uint32_t owner_size) {
+    char *current = memory;
+    t->visited = (uint64_t *) current;
+    current += n_fields / WORD_BITS * sizeof(uint64_t);
+    t->area = (uint32_t *) current;
+    current += n_fields * sizeof(uint32_t);
+    t->order = (uint32_t *) current;
+    current += n_fields * sizeof(uint32_t);
+    t->owner = current;
+    current += n_fields * owner_size;
+    t->pieces = (uint8_t *) current;
+}
+
+
+/** @brief Rozmiar pamięci zajmowanej przez tablice fragmentu planszy.
+ * @param[in] n_fields      – liczba pól fragmentu, wielokrotność
+ *                            @ref WORD_BITS,
+ * @param[in] owner_size    – rozmiar identyfikatora właściciela w bajtach.
+ * @return Rozmiar w bajtach.
+ */
+static uint64_t field_tile_size(uint64_t n_fields, uint32_t owner_size) {
+    return n_fields / WORD_BITS * sizeof(uint64_t)
+           + n_fields * (2 * sizeof(uint32_t) + owner_size + sizeof(uint8_t));
+}
+
+
+/** @brief Utworzenie fragmentu planszy w trybie rzadkim.
+ * Struktura fragmentu i jego tablice zajmują jeden blok pamięci.
+ * @param[in] b             – wskaźnik na planszę.
+ * @return Wskaźnik na fragment z samymi wolnymi polami lub `NULL` jeżeli
+ * alokacja się nie powiodła.
+ */
+static struct tile *field_tile_new(const board_t *b) {
+    struct tile *t = calloc(1, sizeof(struct tile)
+                               + field_tile_size(TILE_FIELDS, b->owner_size));
+    if (ISNULL(t)) {
+        return NULL;
+    }
+    field_tile_init(t, t + 1, TILE_FIELDS, b->owner_size);
+    atomic_init(&t->refs, 1);
+    return t;
+}
+
+
+/** @brief Odłączenie planszy od fragmentu w trybie rzadkim.
+ * Fragment zwalniany jest przez ostatnią korzystającą z niego planszę.
+ * @param[in] t             – wskaźnik na fragment.
+ */
+static void field_tile_release(struct tile *t) {
+    if (atomic_fetch_sub(&t->refs, 1) == 1) {
+        free(t);
+    }
+}
+
+
+/** @brief Skopiowanie współdzielonego fragmentu planszy przed zapisem.
+ * Jeżeli fragment nie jest już używany przez inne plansze, nie trzeba go
+ * kopiować. W obu przypadkach fragment przestaje być oznaczony jako
+ * współdzielony.
+ * @param[in, out] b        – wskaźnik na planszę w trybie rzadkim,
+ * @param[in] index         – numer fragmentu oznaczonego w
+ *                            board::shared_map.
+ * @return Wartość @p true jeżeli udało się skopiować fragment, @p false
+ * w przeciwnym wypadku.
+ */
+static bool field_tile_unshare(board_t *b, uint64_t index) {
+    struct tile *t = b->tiles[index];
+    if (atomic_load(&t->refs) > 1) {
+        uint64_t size = field_tile_size(TILE_FIELDS, b->owner_size);
+        struct tile *copy = malloc(sizeof(struct tile) + size);
+        if (ISNULL(copy)) {
+            return false;
+        }
+        memcpy(copy + 1, t + 1, size);
+        field_tile_init(copy, copy + 1, TILE_FIELDS, b->owner_size);
+        atomic_init(&copy->refs, 1);
+        b->tiles[index] = copy;
+        field_tile_release(t);
+    }
+    b->shared_map[index / WORD_BITS] &= ~((uint64_t) 1 << (index % WORD_BITS));
+    b->shared--;
+    return true;
+}
+
+
+/** @brief Skopiowanie współdzielonych fragmentów prostokąta obszaru.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] area_id       – identyfikator obszaru.
+ * @return Wartość @p true jeżeli żaden fragment zawierający pola obszaru
+ * nie jest już współdzielony, @p false jeżeli zabrakło pamięci.
+ */
+static bool field_area_unshare(board_t *b, uint32_t area_id) {
+    if (b->shared == 0) {
+        return true;
+    }
+    struct area_box box = b->boxes[area_id];
+    for (uint32_t y = box.bottom; y <= box.top && b->shared > 0; ++y) {
+        uint64_t first = (uint64_t) y * b->tiles_x + box.left;
+        uint64_t last = (uint64_t) y * b->tiles_x + box.right;
+        for (uint64_t word = first / WORD_BITS; word <= last / WORD_BITS;
+             ++word) {
+            uint64_t bits = b->shared_map[word];
+            if (word == first / WORD_BITS) {
+                bits &= UINT64_MAX << (first % WORD_BITS);
+            }
+            if (word == last / WORD_BITS) {
+                bits &= UINT64_MAX >> (WORD_BITS - 1 - last % WORD_BITS);
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                uint64_t index = word * WORD_BITS
+                                 + (uint64_t) __builtin_ctzll(bits);
+                if (!field_tile_unshare(b, index)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+/** @brief Skopiowanie wszystkich współdzielonych fragmentów planszy.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli żaden fragment planszy nie jest już
+ * współdzielony, @p false jeżeli zabrakło pamięci.
+ */
+static bool field_unshare_all(board_t *b) {
+    for (uint64_t i = 0; i < b->used_size && b->shared > 0; ++i) {
+        uint64_t index = b->used[i];
+        if ((b->shared_map[index / WORD_BITS] >> (index % WORD_BITS) & 1)
+                && !field_tile_unshare(b, index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** @brief Zaokrąglenie liczby w górę do wielokrotności.
+ * @param[in] value         – zaokrąglana liczba,
+ * @param[in] align         – potęga dwójki.
+ * @return Najmniejsza wielokrotność @p align niemniejsza od @p value.
+ */
+static uint64_t field_round_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+
+/** @brief Liczba pól tablic planszy w trybie gęstym.
+ * Bitmapa odwiedzonych pól zajmuje pełne słowa, więc liczba pól tablic
+ * zaokrąglana jest w górę do wielokrotności @ref WORD_BITS.
+ * @param[in] b             – wskaźnik na planszę.
+ * @return Liczba pól tablic.
+ */
+static uint64_t field_dense_fields(const board_t *b) {
+    return field_round_up(b->stride * b->height, WORD_BITS);
+}
+
+
+/** @brief Wyznaczenie rozmiaru tablic planszy w trybie gęstym.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli tablice zmieszczą się w przestrzeni
+ * adresowej, @p false w przeciwnym wypadku.
+ */
+static bool field_dense_layout(board_t *b) {
+    b->stride = b->tiled ? field_round_up(b->width, SQUARE_SIDE) : b->width;
+    uint64_t n_fields = b->stride * b->height;
+    if (n_fields > SIZE_MAX / (4 * sizeof(uint64_t))) {
+        errno = ENOMEM;
+        return false;
+    }
+    b->dense_size = field_tile_size(field_dense_fields(b), b->owner_size);
+    return true;
+}
+
+
+/** @brief Przypisanie tablic planszy w trybie gęstym do bloku pamięci.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] memory        – wyzerowany blok pamięci o rozmiarze
+ *                            wyznaczonym przez @ref field_dense_layout.
+ */
+static void field_dense_attach(board_t *b, void *memory) {
+    field_tile_init(&b->dense, memory, field_dense_fields(b), b->owner_size);
+    b->dense_tile = &b->dense;
+    b->tiles = &b->dense_tile;
+    b->tiles_count = 1;
+}
+
+
+/** @brief Rozmiar identyfikatora właściciela pola.
+ * @param[in] players       – liczba graczy.
+ * @return Najmniejsza liczba bajtów (1, 2 lub 4) mieszcząca identyfikator
+ * każdego gracza.
+ */
+static uint32_t field_owner_size(uint32_t players) {
+    if (players <= UINT8_MAX) {
+        return sizeof(uint8_t);
+    } else if (players <= UINT16_MAX) {
+        return sizeof(uint16_t);
+    } else {
+        return sizeof(uint32_t);
+    }
+}
+
+
+/** @brief Wyznaczenie rozmiaru tablicy fragmentów planszy w trybie rzadkim.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli tablica zmieści się w przestrzeni
+ * adresowej, @p false w przeciwnym wypadku.
+ */
+static bool field_sparse_layout(board_t *b) {
+    b->sparse = true;
+    b->tiles_x = (uint32_t) (((uint64_t) b->width + TILE_MASK) >> TILE_SHIFT);
+    b->tiles_count = (uint64_t) b->tiles_x
+                     * (((uint64_t) b->height + TILE_MASK) >> TILE_SHIFT);
+    if (b->tiles_count > SIZE_MAX / sizeof(struct tile *)) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+
+/** @brief Rozmieszczenie pól planszy.
+ * @param[in, out] b        – wskaźnik na planszę z ustawionymi wymiarami
+ *                            i rozmiarem identyfikatora właściciela,
+ * @param[in] storage       – sposób przechowywania pól,
+ * @param[in] layout        – układ pól w pamięci.
+ * @return Rozmiar pamięci tablic pól (trybu gęstego) lub tablicy fragmentów
+ * (trybu rzadkiego), albo `UINT64_MAX`, jeżeli nie zmieszczą się one
+ * w przestrzeni adresowej.
+ */
+static uint64_t field_layout(board_t *b, board_storage_t storage,
+                             board_layout_t layout) {
+    b->tiled = layout == BOARD_LAYOUT_SQUARES;
+    bool small = b->width <= BITS_SIDE && b->height <= BITS_SIDE
+                 && b->players <= BITS_PLAYERS;
+    if (storage == BOARD_STORAGE_AUTO) {
+        if (small) {
+            storage = BOARD_STORAGE_BITS;
+        } else if ((uint64_t) b->width * b->height > SPARSE_THRESHOLD) {
+            storage = BOARD_STORAGE_SPARSE;
+        }
+    }
+    if (storage == BOARD_STORAGE_SPARSE) {
+        return field_sparse_layout(b) ? b->tiles_count * sizeof(struct tile *)
+                                      : UINT64_MAX;
+    }
+    if (!field_dense_layout(b)) {
+        return UINT64_MAX;
+    }
+    if (storage != BOARD_STORAGE_BITS || !small) {
+        return b->dense_size;
+    }
+    /* Bitmapy graczy leżą za tablicami pól. */
+    b->bitboard = true;
+    return b->dense_size + (uint64_t) b->players * b->height * sizeof(uint64_t);
+}
+
+
+/** Rozmiar struktury planszy wraz z początkowymi tablicami pomocniczymi. */
+#define HEAD_SIZE (sizeof(board_t) \
+                   + INITIAL_CAPACITY * (sizeof(struct area) + sizeof(field_t) \
+                                         + sizeof(struct area_box)))
+
+
+/** @brief Przygotowanie struktury planszy i tablic pomocniczych.
+ * Struktura planszy leży na początku bloku, a za nią tablice pomocnicze
+ * o pojemności @ref INITIAL_CAPACITY. Przy pierwszym powiększeniu tablice
+ * przenoszone są na stertę.
+ * @param[in] memory        – wyzerowany blok pamięci o rozmiarze
+ *                            @ref HEAD_SIZE,
+ * @param[in] width         – ilość kolumn,
+ * @param[in] height        – ilość wierszy,
+ * @param[in] players       – liczba graczy.
+ * @return Wskaźnik na planszę bez tablic pól.
+ */
+static board_t *field_head_init(void *memory, uint32_t width, uint32_t height,
+                                uint32_t players) {
+    board_t *b = memory;
+    b->width = width;
+    b->height = height;
+    b->players = players;
+    b->owner_size = field_owner_size(players);
+    b->areas = (struct area *) (b + 1);
+    b->areas_capacity = INITIAL_CAPACITY;
+    b->areas_used = 1;
+    b->queue = (field_t *) (b->areas + INITIAL_CAPACITY);
+    b->queue_capacity = INITIAL_CAPACITY;
+    b->boxes = (struct area_box *) (b->queue + INITIAL_CAPACITY);
+    b->boxes_capacity = INITIAL_CAPACITY;
+    return b;
+}
+
+
+uint64_t field_board_size(uint32_t width, uint32_t height, uint32_t players,
+                          board_storage_t storage, board_layout_t layout) {
+    if (width == 0 || height == 0 || players == 0) {
+        return 0;
+    }
+    board_t b = { .width = width, .height = height, .players = players,
+                  .owner_size = field_owner_size(players) };
+    uint64_t size = field_layout(&b, storage, layout);
+    if (size > SIZE_MAX - HEAD_SIZE) {
+        errno = ENOMEM;
+        return 0;
+    }
+    return size + HEAD_SIZE;
+}
+
+
+board_t *field_board_init(void *memory, uint32_t width, uint32_t height,
+                          uint32_t players, board_storage_t storage,
+                          board_layout_t layout) {
+    uint64_t size = field_board_size(width, height, players, storage, layout);
+    if (ISNULL(memory) || size == 0) {
+        return NULL;
+    }
+    board_t *b = field_head_init((char *) memory + size - HEAD_SIZE, width,
+                                 height, players);
+    field_layout(b, storage, layout);
+    if (b->sparse) {
+        b->tiles = memory;
+    } else {
+        field_dense_attach(b, memory);
+    }
+    if (b->bitboard) {
+        b->bits = (uint64_t *) ((char *) memory + b->dense_size);
+    }
+    return b;
+}
+
+
+/** @brief Utworzenie planszy przechowywanej w pliku, bez tablic pól.
+ * @param[in] width         – ilość kolumn,
+ * @param[in] height        – ilość wierszy,
+ * @param[in] players       – liczba graczy.
+ * @return Wskaźnik do planszy lub `NULL` jeżeli alokacja się nie powiodła
+ * lub któryś z parametrów jest zerem.
+ */
+static board_t *field_board_alloc(uint32_t width, uint32_t height,
+                                  uint32_t players) {
+    if (width == 0 || height == 0 || players == 0) {
+        return NULL;
+    }
+    void *memory = calloc(1, HEAD_SIZE);
+    if (ISNULL(memory)) {
+        return NULL;
+    }
+    board_t *b = field_head_init(memory, width, height, players);
+    b->separate = true;
+    return b;
+}
+
+
+/** @brief Rozmieszczenie planszy w pliku.
+ * Funkcja wyznacza rozmiar pliku planszy i pojemność tablicy obszarów, tak
+ * aby tablica nie musiała być nigdy powiększana.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] extra_size    – rozmiar danych użytkownika.
+ * @return Położenie tablic pól w pliku lub `0`, jeżeli plik byłby zbyt duży.
+ */
+static uint64_t field_file_layout(board_t *b, uint64_t extra_size) {
+    uint64_t n_fields = (uint64_t) b->width * b->height;
+    if (!field_dense_layout(b) || extra_size > SIZE_MAX / 2) {
+        errno = ENOMEM;
+        return 0;
+    }
+    /* Tak jak w pamięci, tablica obszarów ma najwyżej 2^31 elementów. */
+    b->areas_capacity = n_fields > UINT32_MAX / 2 + 1 - FILE_AREAS_MARGIN ?
+                        UINT32_MAX / 2 + 1
+                        : (uint32_t) n_fields + FILE_AREAS_MARGIN;
+    uint64_t dense_offset = field_round_up(
+            field_round_up(sizeof(struct board_file), FILE_ALIGN) + extra_size,
+            (uint64_t) sysconf(_SC_PAGESIZE));
+    b->file_size = dense_offset + b->dense_size
+                   + (uint64_t) b->areas_capacity * sizeof(struct area);
+    if (b->file_size > SIZE_MAX || b->file_size > INT64_MAX) {
+        errno = ENOMEM;
+        return 0;
+    }
+    return dense_offset;
+}
+
+
+/** @brief Zmapowanie pliku planszy.
+ * Plik mapowany jest jako współdzielony, więc zmiany planszy trafiają
+ * do pliku, a system może usuwać z pamięci rzadko używane strony.
+ * Plik otwarty tylko do odczytu mapowany jest prywatnie: strony czytane są
+ * z pliku dopiero przy pierwszym dostępie, a zapisywane (np. pomocnicze
+ * tablice planszy) kopiowane są do pamięci procesu.
+ * @param[in, out] b        – wskaźnik na planszę z wyznaczonym rozmieszczeniem,
+ * @param[in] fd            – deskryptor pliku planszy,
+ * @param[in] dense_offset  – położenie tablic pól w pliku.
+ * @return Wartość @p true jeżeli udało się zmapować plik, @p false
+ * w przeciwnym wypadku.
+ */
+static bool field_file_map(board_t *b, int fd, uint64_t dense_offset) {
+    void *memory = mmap(NULL, b->file_size, PROT_READ | PROT_WRITE,
+                        b->file_private ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    b->file = memory;
+    field_dense_attach(b, (char *) memory + dense_offset);
+    b->areas = (struct area *) ((char *) memory + dense_offset + b->dense_size);
+    return true;
+}
+
+
+board_t *field_board_map(uint32_t width, uint32_t height, uint32_t players,
+                         board_layout_t layout, const char *path,
+                         uint64_t extra_size) {
+    if (ISNULL(path)) {
+        return NULL;
+    }
+    board_t *b = field_board_alloc(width, height, players);
+    if (ISNULL(b)) {
+        return NULL;
+    }
+    b->tiled = layout == BOARD_LAYOUT_SQUARES;
+    uint64_t dense_offset = field_file_layout(b, extra_size);
+    if (dense_offset == 0) {
+        field_board_delete(b);
+        return NULL;
+    }
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        field_board_delete(b);
+        return NULL;
+    }
+    /* Plik powiększony przez ftruncate jest wypełniony zerami i nie zajmuje
+     * miejsca na dysku, dopóki nic się do niego nie zapisze. */
+    bool mapped = ftruncate(fd, (off_t) b->file_size) == 0
+                  && field_file_map(b, fd, dense_offset);
+    close(fd);
+    if (!mapped) {
+        field_board_delete(b);
+        return NULL;
+    }
+    *b->file = (struct board_file) { .magic = FILE_MAGIC, .width = width,
+                                     .height = height, .players = players,
+                                     .tiled = b->tiled,
+                                     .extra_size = extra_size };
+    return b;
+}
+
+
+/** @brief Powiększenie tablicy pomocniczej planszy.
+ * Tablice o pojemności @ref INITIAL_CAPACITY leżą w bloku pamięci planszy,
+ * więc przy pierwszym powiększeniu są kopiowane na stertę.
+ * @param[in] array         – wskaźnik na tablicę,
+ * @param[in] old_capacity  – dotychczasowa pojemność tablicy,
+ * @param[in] capacity      – nowa pojemność tablicy,
+ * @param[in] element_size  – rozmiar elementu tablicy.
+ * @return Wskaźnik na powiększoną tablicę lub `NULL` jeżeli alokacja się nie
+ * powiodła (wtedy dotychczasowa tablica pozostaje nienaruszona).
+ */
+static void *field_grow(void *array, uint64_t old_capacity, uint64_t capacity,
+                        size_t element_size) {
+    if (old_capacity > INITIAL_CAPACITY) {
+        return realloc(array, capacity * element_size);
+    }
+    void *result = malloc(capacity * element_size);
+    if (!ISNULL(result)) {
+        memcpy(result, array, old_capacity * element_size);
+    }
+    return result;
+}
+
+
+/** @brief Rezerwacja miejsca w kolejce algorytmu BFS.
+ * Podwaja pojemność kolejki, dopóki nie zmieści @p count pól.
+ * @param[in,out] b     – wskaźnik na planszę,
+ * @param[in] count     – wymagana liczba pól w kolejce.
+ * @return Wartość @p true, jeżeli kolejka mieści @p count pól, a @p false,
+ * jeżeli nie udało się zaalokować pamięci.
+ */
+static bool field_queue_reserve(board_t *b, uint64_t count) {
+    uint64_t capacity = b->queue_capacity;
+    while (count > capacity) {
+        if (capacity > UINT64_MAX / 2 / sizeof(field_t)) {
+            return false;
+        }
+        capacity *= 2;
+    }
+    if (capacity != b->queue_capacity) {
+        field_t *queue = field_grow(b->queue, b->queue_capacity, capacity,
+                                    sizeof(field_t));
+        if (ISNULL(queue)) {
+            return false;
+        }
+        b->queue = queue;
+        b->queue_capacity = capacity;
+    }
+    return true;
+}
+
+
+board_t *field_board_open(const char *path, bool read_only) {
+    if (ISNULL(path)) {
+        return NULL;
+    }
+    int fd = open(path, read_only ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct board_file header;
+    struct stat info;
+    board_t *b = NULL;
+    if (pread(fd, &header, sizeof(header), 0) == sizeof(header)
+            && fstat(fd, &info) == 0 && header.magic == FILE_MAGIC
+            && header.closed != 0) {
+        b = field_board_alloc(header.width, header.height, header.players);
+    }
+    uint64_t dense_offset = 0;
+    if (!ISNULL(b)) {
+        b->tiled = header.tiled != 0;
+        b->file_private = read_only;
+        dense_offset = field_file_layout(b, header.extra_size);
+    }
+    if (dense_offset == 0 || (uint64_t) info.st_size != b->file_size
+            || header.areas_used > b->areas_capacity
+            || header.free_area >= header.areas_used) {
+        close(fd);
+        field_board_delete(b);
+        errno = EINVAL;
+        return NULL;
+    }
+    bool mapped = field_file_map(b, fd, dense_offset);
+    close(fd);
+    if (!mapped) {
+        field_board_delete(b);
+        return NULL;
+    }
+    /* Kolejka algorytmu BFS musi pomieścić wszystkie zajęte pola. */
+    if (!field_queue_reserve(b, header.occupied + 1)) {
+        field_board_delete(b);
+        return NULL;
+    }
+    b->occupied = header.occupied;
+    b->areas_used = header.areas_used;
+    b->free_area = header.free_area;
+    b->dfs_clock = header.dfs_clock;
+    if (!read_only) {
+        b->file->closed = 0;
+    }
+    return b;
+}
+
+
+void *field_board_extra(const board_t *b, uint64_t *size) {
+    if (ISNULL(b) || ISNULL(b->file)) {
+        return NULL;
+    }
+    if (!ISNULL(size)) {
+        *size = b->file->extra_size;
+    }
+    return (char *) b->file + field_round_up(sizeof(struct board_file),
+                                             FILE_ALIGN);
+}
+
+
+board_storage_t field_board_storage(const board_t *b) {
+    if (b->sparse) {
+        return BOARD_STORAGE_SPARSE;
+    }
+    return b->bitboard ? BOARD_STORAGE_BITS : BOARD_STORAGE_DENSE;
+}
+
+
+board_layout_t field_board_layout(const board_t *b) {
+    return b->tiled ? BOARD_LAYOUT_SQUARES : BOARD_LAYOUT_ROWS;
+}
+
+
+/** @brief Przygotowanie bitmapy współdzielonych fragmentów planszy.
+ * @param[in, out] b        – wskaźnik na planszę w trybie rzadkim.
+ * @return Wartość @p true jeżeli bitmapa istnieje, @p false jeżeli nie udało
+ * się jej przydzielić.
+ */
+static bool field_share_prepare(board_t *b) {
+    if (ISNULL(b->shared_map)) {
+        b->shared_map = calloc((b->tiles_count + WORD_BITS - 1) / WORD_BITS,
+                               sizeof(uint64_t));
+    }
+    return !ISNULL(b->shared_map);
+}
+
+
+/** @brief Oznaczenie fragmentu planszy jako współdzielonego.
+ * @param[in, out] b        – wskaźnik na planszę w trybie rzadkim,
+ * @param[in] index         – numer fragmentu.
+ */
+static void field_share_mark(board_t *b, uint64_t index) {
+    uint64_t bit = (uint64_t) 1 << (index % WORD_BITS);
+    if ((b->shared_map[index / WORD_BITS] & bit) == 0) {
+        b->shared_map[index / WORD_BITS] |= bit;
+        b->shared++;
+    }
+}
+
+
+/** @brief Przydzielenie tablicy pomocniczej kopii planszy.
+ * Tablica o pojemności @ref INITIAL_CAPACITY zostaje w bloku planszy.
+ * @param[in, out] array    – wskaźnik na tablicę w bloku planszy; zastępowany
+ *                            przydzieloną tablicą,
+ * @param[in] capacity      – pojemność tablicy,
+ * @param[in] element_size  – rozmiar elementu tablicy.
+ * @return Wartość @p true jeżeli udało się przydzielić tablicę, @p false
+ * w przeciwnym wypadku.
+ */
+static bool field_copy_alloc(void **array, uint64_t capacity,
+                             size_t element_size) {
+    if (capacity > INITIAL_CAPACITY) {
+        void *result = malloc(capacity * element_size);
+        if (ISNULL(result)) {
+            return false;
+        }
+        *array = result;
+    }
+    return true;
+}
+
+
+bool field_board_copy(board_t *b, board_t *source) {
+    if (ISNULL(b) || ISNULL(source) || b->occupied != 0) {
+        return false;
+    }
+    if (source->sparse && (!field_share_prepare(source)
+                           || !field_share_prepare(b))) {
+        return false;
+    }
+    if (source->used_size > 0) {
+        b->used = malloc(source->used_size * sizeof(uint64_t));
+        if (ISNULL(b->used)) {
+            return false;
+        }
+        b->used_capacity = source->used_size;
+    }
+    /* Tablica obszarów planszy w pliku jest znacznie większa niż potrzeba. */
+    uint64_t capacity = INITIAL_CAPACITY;
+    while (capacity < (uint64_t) source->areas_used + ADJOINING_FIELDS + 1
+           && capacity <= UINT32_MAX / 2) {
+        capacity *= 2;
+    }
+    void *areas = b->areas, *boxes = b->boxes, *queue = b->queue;
+    if (!field_copy_alloc(&areas, capacity, sizeof(struct area))) {
+        return false;
+    }
+    b->areas = areas;
+    b->areas_capacity = (uint32_t) capacity;
+    if (b->sparse) {
+        if (!field_copy_alloc(&boxes, capacity, sizeof(struct area_box))) {
+            return false;
+        }
+        b->boxes = boxes;
+        b->boxes_capacity = (uint32_t) capacity;
+    }
+    if (!field_copy_alloc(&queue, source->queue_capacity, sizeof(field_t))) {
+        return false;
+    }
+    b->queue = queue;
+    b->queue_capacity = source->queue_capacity;
+    memcpy(b->areas, source->areas, source->areas_used * sizeof(struct area));
+    if (b->sparse) {
+        memcpy(b->boxes, source->boxes,
+               source->areas_used * sizeof(struct area_box));
+        for (uint64_t i = 0; i < source->used_size; ++i) {
+            uint64_t index = source->used[i];
+            atomic_fetch_add(&source->tiles[index]->refs, 1);
+            b->tiles[index] = source->tiles[index];
+            b->used[i] = index;
+            field_share_mark(b, index);
+            field_share_mark(source, index);
+        }
+        b->used_size = source->used_size;
+    } else {
+        memcpy(b->tiles[0]->visited, source->tiles[0]->visited,
+               source->dense_size);
+        if (b->bitboard) {
+            memcpy(b->bits, source->bits,
+                   (uint64_t) b->players * b->height * sizeof(uint64_t));
+        }
+    }
+    b->areas_used = source->areas_used;
+    b->free_area = source->free_area;
+    b->dfs_clock = source->dfs_clock;
+    b->occupied = source->occupied;
+    return true;
+}
+
+
+void field_board_delete(board_t *b) {
+    if (ISNULL(b)) {
+        return;
+    }
+    for (uint64_t i = 0; i < b->used_size; ++i) {
+        field_tile_release(b->tiles[b->used[i]]);
+    }
+    free(b->used);
+    free(b->shared_map);
+    free(b->journal.changes);
+    free(b->journal.cells);
+    free(b->journal.areas);
+    if (!ISNULL(b->file) && b->file_private) {
+        munmap(b->file, b->file_size);
+    } else if (!ISNULL(b->file)) {
+        b->file->occupied = b->occupied;
+        b->file->areas_used = b->areas_used;
+        b->file->free_area = b->free_area;
+        b->file->dfs_clock = b->dfs_clock;
+        b->file->closed = 1;
+        munmap(b->file, b->file_size);
+    } else if (b->areas != (struct area *) (b + 1)) {
+        free(b->areas);
+    }
+    if (b->queue_capacity > INITIAL_CAPACITY) {
+        free(b->queue);
+    }
+    if (b->boxes_capacity > INITIAL_CAPACITY) {
+        free(b->boxes);
+    }
+    free(b->dfs);
+    if (b->separate) {
+        free(b);
+    }
+}
+
+
+bool field_board_reset(board_t *b) {
+    if (ISNULL(b) || b->file_private) {
+        return false;
+    }
+    if (b->sparse) {
+        /* Fragmenty używane tylko przez tę planszę są czyszczone zamiast
+         * zwalniane, więc odczyt z innego wątku nie trafia na zwolnioną
+         * pamięć. Fragmenty współdzielone zostają przy kopiach planszy. */
+        uint64_t size = field_tile_size(TILE_FIELDS, b->owner_size);
+        uint64_t kept = 0;
+        for (uint64_t i = 0; i < b->used_size; ++i) {
+            uint64_t index = b->used[i];
+            struct tile *t = b->tiles[index];
+            if (atomic_load(&t->refs) > 1) {
+                b->tiles[index] = NULL;
+                field_tile_release(t);
+            } else {
+                memset(t + 1, 0, size);
+                b->used[kept++] = index;
+            }
+        }
+        b->used_size = kept;
+        free(b->shared_map);
+        b->shared_map = NULL;
+        b->shared = 0;
+    } else {
+        /* Tablice pól planszy gęstej zaczynają się bitmapą odwiedzonych pól.
+         */
+        memset(b->dense.visited, 0, b->dense_size);
+    }
+    if (b->bitboard) {
+        memset(b->bits, 0, (uint64_t) b->players * b->height
+                           * sizeof(uint64_t));
+    }
+    memset(b->areas, 0, b->areas_used * sizeof(struct area));
+    memset(b->boxes, 0, (b->areas_used < b->boxes_capacity ? b->areas_used
+                                                           : b->boxes_capacity)
+                        * sizeof(struct area_box));
+    b->areas_used = 1;
+    b->free_area = 0;
+    b->occupied = 0;
+    b->dfs_clock = 0;
+    struct journal *j = &b->journal;
+    j->open = false;
+    j->changes_size = 0;
+    j->cells_size = 0;
+    j->areas_size = 0;
+    return true;
+}
+
+
+uint32_t field_owner(const board_t *b, field_t field) {
+    if (ISNULL(b) || field == FIELD_NONE) {
+        return 0;
+    }
+    return owner_get(b, field_cell(b, field));
+}
+
+
+/** @brief Liczba kolejnych pól wiersza leżących obok siebie w pamięci.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] x             – numer kolumny pierwszego pola.
+ * @return Liczba pól od kolumny @p x do końca kwadratu, fragmentu lub
+ * wiersza planszy.
+ */
+static uint32_t field_run(const board_t *b, uint32_t x) {
+    if (b->tiled) {
+        return SQUARE_SIDE - (x & SQUARE_MASK);
+    }
+    if (b->sparse) {
+        return TILE_SIDE - (x & TILE_MASK);
+    }
+    return b->width - x;
+}
+
+
+void field_owners(const board_t *b, uint32_t x, uint32_t y, uint32_t count,
+                  uint32_t *owners) {
+    while (count > 0) {
+        struct cell c = field_cell(b, field_at(x, y));
+        uint32_t run = field_run(b, x);
+        run = run < count ? run : count;
+        if (ISNULL(c.tile)) {
+            memset(owners, 0, run * sizeof(uint32_t));
+        } else if (b->owner_size == sizeof(uint8_t)) {
+            const uint8_t *src = (const uint8_t *) c.tile->owner + c.index;
+            for (uint32_t i = 0; i < run; ++i) {
+                owners[i] = src[i];
+            }
+        } else if (b->owner_size == sizeof(uint16_t)) {
+            const uint16_t *src = (const uint16_t *) c.tile->owner + c.index;
+            for (uint32_t i = 0; i < run; ++i) {
+                owners[i] = src[i];
+            }
+        } else {
+            memcpy(owners, (const uint32_t *) c.tile->owner + c.index,
+                   run * sizeof(uint32_t));
+        }
+        owners += run;
+        x += run;
+        count -= run;
+    }
+}
+
+
+const void *field_owners_array(const board_t *b, uint32_t *owner_size,
+                               uint64_t *stride) {
+    if (ISNULL(b) || b->sparse || b->tiled) {
+        return NULL;
+    }
+    *owner_size = b->owner_size;
+    *stride = b->stride;
+    return b->tiles[0]->owner;
+}
+
+
+void field_gather(const board_t *b, const field_t *fields, uint64_t count,
+                  uint32_t *owners) {
+    for (uint64_t i = 0; i < count; ++i) {
+        owners[i] = owner_get(b, field_cell(b, fields[i]));
+    }
+}
+
+
+uint32_t field_adjoining(const board_t *b, field_t field,
+                         field_t adjoining[ADJOINING_FIELDS]) {
+    uint32_t x = FIELD_X(field), y = FIELD_Y(field);
+    uint32_t last = 0;
+    if (y + 1 < b->height) {
+        adjoining[last++] = field_at(x, y + 1);
+    }
+    if (x > 0) {
+        adjoining[last++] = field_at(x - 1, y);
+    }
+    if (y > 0) {
+        adjoining[last++] = field_at(x, y - 1);
+    }
+    if (x + 1 < b->width) {
+        adjoining[last++] = field_at(x + 1, y);
+    }
+    for (uint32_t i = last; i < ADJOINING_FIELDS; ++i) {
+        adjoining[i] = FIELD_NONE;
+    }
+    return last;
+}
+
+
+/** @brief Różne obszary gracza sąsiadujące z polem.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola,
+ * @param[in] player_id     – identyfikator gracza,
+ * @param[out] starts       – po jednym polu z każdego obszaru,
+ * @param[out] areas        – identyfikatory obszarów,
+ * @param[out] largest      – numer największego z obszarów (pierwszego
+ *                            z największych) w tablicy @p areas.
+ * @return Liczba obszarów.
+ */
+static uint32_t field_adjoining_areas(const board_t *b, field_t field,
+                                      uint32_t player_id,
+                                      field_t starts[ADJOINING_FIELDS],
+                                      uint32_t areas[ADJOINING_FIELDS],
+                                      uint32_t *largest) {
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(b, field, adjoining);
+    uint32_t count = 0;
+    *largest = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        struct cell slot = field_cell(b, adjoining[i]);
+        if (owner_get(b, slot) != player_id) {
+            continue;
+        }
+        uint32_t area = *cell_area(slot);
+        bool seen = false;
+        for (uint32_t j = 0; j < count; ++j) {
+            seen |= areas[j] == area;
+        }
+        if (!seen) {
+            if (count > 0
+                    && b->areas[area].size > b->areas[areas[*largest]].size) {
+                *largest = count;
+            }
+            starts[count] = adjoining[i];
+            areas[count++] = area;
+        }
+    }
+    return count;
+}
+
+
+/** @brief Skopiowanie współdzielonych fragmentów, które zmieni ruch na polu.
+ * Zajęcie pola zmienia pola jego fragmentu oraz obszarów dołączanych
+ * do największego z sąsiednich obszarów gracza, a zwolnienie – pola
+ * dzielonego obszaru. Gracz zajmujący pole nie jest znany, więc kopiowane
+ * są fragmenty obszarów wszystkich sąsiadów poza największymi.
+ * @param[in, out] b        – wskaźnik na planszę w trybie rzadkim,
+ * @param[in] field         – identyfikator pola,
+ * @param[in] index         – numer fragmentu zawierającego pole.
+ * @return Wartość @p true jeżeli udało się skopiować fragmenty, @p false
+ * w przeciwnym wypadku.
+ */
+static bool field_unshare_near(board_t *b, field_t field, uint64_t index) {
+    if (b->shared == 0) {
+        return true;
     }
-    field_t *f = &fields[(uint64_t) max_x * y + x];
-    f->visited = false;
-    f->owner = 0;
-    f->area = (struct area) { .prev = &f->area, .next = &f->area,
-                              .repr = &f->area, .size = 1};
-    for (uint32_t i = 0; i < ADJOINING_FIELDS; ++i) {
-        f->adjoining[i] = NULL;
+    if ((b->shared_map[index / WORD_BITS] >> (index % WORD_BITS) & 1)
+            && !field_tile_unshare(b, index)) {
+        return false;
     }
-    uint32_t last = 0;
-    int v_x[ADJOINING_FIELDS] = {0, -1, 0, 1};
-    int v_y[ADJOINING_FIELDS] = {1, 0, -1, 0};
-    for (uint32_t i = 0; i < ADJOINING_FIELDS; ++i) {
-        if (x + v_x[i] + 1 > 0 && x + v_x[i] + 1 <= max_x
-                && y + v_y[i] + 1 > 0 && y + v_y[i] + 1 <= max_y) {
-            f->adjoining[last] =
-                    &fields[(y + v_y[i]) * (uint64_t) max_x + x + v_x[i]];
-            ++last;
+    struct cell slot = field_cell(b, field);
+    if (owner_get(b, slot) != 0 && !field_area_unshare(b, *cell_area(slot))) {
+        return false;
+    }
+    field_t adjoining[ADJOINING_FIELDS], starts[ADJOINING_FIELDS];
+    uint32_t areas[ADJOINING_FIELDS], largest;
+    uint32_t size = field_adjoining(b, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t player_id = owner_get(b, field_cell(b, adjoining[i]));
+        if (player_id == 0) {
+            continue;
+        }
+        uint32_t count = field_adjoining_areas(b, field, player_id, starts,
+                                               areas, &largest);
+        for (uint32_t j = 0; j < count; ++j) {
+            if (j != largest && !field_area_unshare(b, areas[j])) {
+                return false;
+            }
         }
     }
-    f->size_adjoining = last;
+    return true;
 }
 
 
-uint32_t field_owner(const field_t *field) {
-    if (ISNULL(field)) {
-        return 0;
-    } else {
-        return field->owner;
+bool field_reserve(board_t *b, field_t field) {
+    if (ISNULL(b) || field == FIELD_NONE) {
+        return false;
+    }
+    if (b->sparse) {
+        uint64_t index = field_tile_index(b, field);
+        if (ISNULL(b->tiles[index])) {
+            if (b->used_size == b->used_capacity) {
+                uint64_t capacity = b->used_capacity == 0 ? INITIAL_CAPACITY
+                                                          : b->used_capacity * 2;
+                uint64_t *used = realloc(b->used, capacity * sizeof(uint64_t));
+                if (ISNULL(used)) {
+                    return false;
+                }
+                b->used = used;
+                b->used_capacity = capacity;
+            }
+            b->tiles[index] = field_tile_new(b);
+            if (ISNULL(b->tiles[index])) {
+                return false;
+            }
+            b->used[b->used_size++] = index;
+        }
+        if (!field_unshare_near(b, field, index)) {
+            return false;
+        }
+    }
+    /* Zajęcie pola tworzy jeden obszar, a zwolnienie – co najwyżej tyle
+     * obszarów, ilu sąsiadów ma pole. */
+    if (b->areas_used + ADJOINING_FIELDS + 1 > b->areas_capacity) {
+        /* Tablica obszarów w pliku ma stały rozmiar. */
+        if (!ISNULL(b->file) || b->areas_capacity > UINT32_MAX / 2) {
+            return false;
+        }
+        uint32_t capacity = b->areas_capacity * 2;
+        struct area *areas = field_grow(b->areas, b->areas_capacity, capacity,
+                                        sizeof(struct area));
+        if (ISNULL(areas)) {
+            return false;
+        }
+        b->areas = areas;
+        b->areas_capacity = capacity;
+    }
+    if (b->sparse && b->boxes_capacity < b->areas_capacity) {
+        struct area_box *boxes = field_grow(b->boxes, b->boxes_capacity,
+                                            b->areas_capacity,
+                                            sizeof(struct area_box));
+        if (ISNULL(boxes)) {
+            return false;
+        }
+        b->boxes = boxes;
+        b->boxes_capacity = b->areas_capacity;
+    }
+    /* Algorytm BFS odwiedza jedynie zajęte pola. */
+    return field_queue_reserve(b, b->occupied + 1);
+}
+
+
+/** @brief Utrata dziennika zmian planszy.
+ * Gdy zabraknie pamięci na zapis, dziennik jest czyszczony, a kolejne zapisy
+ * pomijane aż do rozpoczęcia następnej zmiany.
+ * @param[in, out] b        – wskaźnik na planszę.
+ */
+static void field_journal_lose(board_t *b) {
+    struct journal *j = &b->journal;
+    free(j->changes);
+    free(j->cells);
+    free(j->areas);
+    *j = (struct journal) { .enabled = j->enabled };
+}
+
+
+/** @brief Zapewnienie miejsca na kolejny element tablicy dziennika.
+ * @param[in, out] array    – wskaźnik na tablicę,
+ * @param[in, out] capacity – rozmiar tablicy,
+ * @param[in] size          – liczba elementów tablicy,
+ * @param[in] element_size  – rozmiar elementu tablicy.
+ * @return Wartość @p true jeżeli tablica ma miejsce na kolejny element,
+ * @p false jeżeli nie udało się jej powiększyć.
+ */
+static bool field_journal_grow(void **array, uint64_t *capacity, uint64_t size,
+                               size_t element_size) {
+    if (size < *capacity) {
+        return true;
+    }
+    uint64_t new_capacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity * 2;
+    void *result = realloc(*array, new_capacity * element_size);
+    if (ISNULL(result)) {
+        return false;
     }
+    *array = result;
+    *capacity = new_capacity;
+    return true;
 }
 
 
-void field_set_owner(field_t *field, uint32_t new_owner) {
-    if (ISNULL(field)) {
+/** @brief Zapamiętanie stanu pola przed zapisem.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] c             – położenie pola,
+ * @param[in] field         – identyfikator pola.
+ */
+static inline void field_log_cell(board_t *b, struct cell c, field_t field) {
+    struct journal *j = &b->journal;
+    if (!j->open) {
+        return;
+    }
+    if (!field_journal_grow((void **) &j->cells, &j->cells_capacity,
+                            j->cells_size, sizeof(struct journal_cell))) {
+        field_journal_lose(b);
         return;
     }
-    field->owner = new_owner;
+    j->cells[j->cells_size++] = (struct journal_cell) {
+            .field = field, .area = *cell_area(c), .owner = owner_get(b, c) };
 }
 
 
-void field_adjoining(field_t *field, field_t *adjoining[ADJOINING_FIELDS]) {
-    if (ISNULL(field) || ISNULL(adjoining)) {
+/** @brief Zapamiętanie stanu obszaru przed zmianą.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] id            – identyfikator obszaru.
+ */
+static inline void field_log_area(board_t *b, uint32_t id) {
+    struct journal *j = &b->journal;
+    if (!j->open) {
         return;
     }
-    for (uint32_t i = 0; i < field->size_adjoining; ++i) {
-        adjoining[i] = field->adjoining[i];
+    if (!field_journal_grow((void **) &j->areas, &j->areas_capacity,
+                            j->areas_size, sizeof(struct journal_area))) {
+        field_journal_lose(b);
+        return;
     }
-    for (uint32_t i = field->size_adjoining; i < ADJOINING_FIELDS; ++i) {
-        adjoining[i] = NULL;
+    struct journal_area *entry = &j->areas[j->areas_size++];
+    entry->id = id;
+    entry->area = b->areas[id];
+    if (b->sparse) {
+        entry->box = b->boxes[id];
     }
 }
 
 
-uint32_t field_adjoining_size(const field_t *field) {
-    if (ISNULL(field)) {
-        return 0;
+/** @brief Przydzielenie identyfikatora nowego, pustego obszaru.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Identyfikator obszaru.
+ */
+static uint32_t field_area_new(board_t *b) {
+    uint32_t id;
+    if (b->free_area != 0) {
+        id = b->free_area;
+        b->free_area = b->areas[id].next_free;
+    } else {
+        id = b->areas_used++;
     }
-    return field->size_adjoining;
+    field_log_area(b, id);
+    b->areas[id].size = 0;
+    b->areas[id].stale = true;
+    return id;
 }
 
 
-field_t *field_board_new(uint32_t width, uint32_t height) {
-    if (width == 0 || height == 0) {
-        return NULL;
+/** @brief Ustawienie prostokąta obszaru złożonego z jednego pola.
+ * Prostokąty obszarów utrzymywane są tylko w trybie rzadkim.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] id            – identyfikator obszaru,
+ * @param[in] field         – identyfikator pola.
+ */
+static inline void field_box_set(board_t *b, uint32_t id, field_t field) {
+    if (b->sparse) {
+        uint32_t x = FIELD_X(field) >> TILE_SHIFT;
+        uint32_t y = FIELD_Y(field) >> TILE_SHIFT;
+        b->boxes[id] = (struct area_box) { .left = x, .bottom = y,
+                                           .right = x, .top = y };
     }
-    size_t n_fields = (size_t) width * height;
-    field_t *result = calloc(n_fields, sizeof(field_t));
-    if (ISNULL(result)) {
-        return NULL;
+}
+
+
+/** @brief Powiększenie prostokąta obszaru o fragment zawierający pole.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] id            – identyfikator obszaru,
+ * @param[in] field         – identyfikator pola.
+ */
+static inline void field_box_add(board_t *b, uint32_t id, field_t field) {
+    if (b->sparse) {
+        uint32_t x = FIELD_X(field) >> TILE_SHIFT;
+        uint32_t y = FIELD_Y(field) >> TILE_SHIFT;
+        struct area_box *box = &b->boxes[id];
+        box->left = x < box->left ? x : box->left;
+        box->bottom = y < box->bottom ? y : box->bottom;
+        box->right = x > box->right ? x : box->right;
+        box->top = y > box->top ? y : box->top;
+    }
+}
+
+
+/** @brief Powiększenie prostokąta obszaru o prostokąt innego obszaru.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] to            – identyfikator powiększanego obszaru,
+ * @param[in] from          – identyfikator dołączanego obszaru.
+ */
+static inline void field_box_merge(board_t *b, uint32_t to, uint32_t from) {
+    if (b->sparse) {
+        struct area_box *box = &b->boxes[to], other = b->boxes[from];
+        box->left = other.left < box->left ? other.left : box->left;
+        box->bottom = other.bottom < box->bottom ? other.bottom : box->bottom;
+        box->right = other.right > box->right ? other.right : box->right;
+        box->top = other.top > box->top ? other.top : box->top;
     }
-    for (uint32_t i = 0; i < height; ++i) {
-        for (uint32_t j = 0; j < width; ++j) {
-            field_init(result, j, i, width, height);
+}
+
+
+/** @brief Zwolnienie identyfikatora obszaru.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] id            – identyfikator obszaru.
+ */
+static void field_area_delete(board_t *b, uint32_t id) {
+    field_log_area(b, id);
+    b->areas[id].size = 0;
+    b->areas[id].next_free = b->free_area;
+    b->free_area = id;
+}
+
+
+/** @brief Zmiana identyfikatora obszaru pól spójnej części.
+ * Procedura przechodzi algorytmem BFS pola gracza @p player_id o identyfikatorze
+ * obszaru @p from osiągalne z pola @p start i przypisuje im obszar @p to.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] start         – identyfikator pola początkowego,
+ * @param[in] player_id     – identyfikator gracza,
+ * @param[in] from          – poprzedni identyfikator obszaru,
+ * @param[in] to            – nowy identyfikator obszaru.
+ * @return Liczba pól, którym zmieniono obszar.
+ */
+static uint64_t field_relabel(board_t *b, field_t start, uint32_t player_id,
+                              uint32_t from, uint32_t to) {
+    uint64_t head = 0, tail = 0;
+    struct cell start_slot = field_cell(b, start);
+    field_log_cell(b, start_slot, start);
+    *cell_area(start_slot) = to;
+    b->queue[tail++] = start;
+    while (head < tail) {
+        field_t adjoining[ADJOINING_FIELDS];
+        uint32_t size = field_adjoining(b, b->queue[head++], adjoining);
+        for (uint32_t i = 0; i < size; ++i) {
+            struct cell slot = field_cell(b, adjoining[i]);
+            if (owner_get(b, slot) == player_id && *cell_area(slot) == from) {
+                field_log_cell(b, slot, adjoining[i]);
+                *cell_area(slot) = to;
+                b->queue[tail++] = adjoining[i];
+            }
         }
     }
+    return tail;
+}
+
+
+/** @brief Bitmapa pól gracza w trybie bitowym.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] player_id     – identyfikator gracza.
+ * @return Wskaźnik na pierwszy wiersz bitmapy gracza.
+ */
+static inline uint64_t *field_bits(const board_t *b, uint32_t player_id) {
+    return &b->bits[(uint64_t) (player_id - 1) * b->height];
+}
+
+
+/** @brief Rozlanie pól wiersza po ciągłych odcinkach maski.
+ * W stronę starszych bitów rozlewa dodawanie (przeniesienie biegnie do końca
+ * odcinka), w stronę młodszych – przesunięcia o 1, 2, 4, 8, 16 i 32 bity
+ * ograniczone maską.
+ * @param[in] row           – pola początkowe, podzbiór @p mask,
+ * @param[in] mask          – pola, po których można się rozlewać.
+ * @return Pola odcinków @p mask zawierających któreś z pól @p row.
+ */
+static inline uint64_t field_bits_spread(uint64_t row, uint64_t mask) {
+    uint64_t result = (((mask + row) ^ mask) & mask) | row;
+    uint64_t open = mask;
+    for (uint32_t shift = 1; shift < WORD_BITS; shift *= 2) {
+        result |= open & (result >> shift);
+        open &= open >> shift;
+    }
     return result;
 }
 
 
-uint32_t field_count_adjoining_areas(const field_t *field, uint32_t player_id) {
-    uint32_t result = 0;
-    for (uint32_t i = 0; i < field->size_adjoining; ++i) {
-        if (field->adjoining[i]->owner == player_id) {
-            int add = 1;
-            for (uint32_t j = i + 1; j < field->size_adjoining; ++j) {
-                if (field->adjoining[j]->owner == player_id &&
-                        field->adjoining[i]->area.repr == field->adjoining[j]->area.repr) {
-                    add = 0;
-                    break;
-                }
+/** @brief Wyznaczenie spójnej części pól gracza zawierającej dane pole.
+ * Części szukamy całymi wierszami: na przemian w dół i w górę planszy każdy
+ * wiersz powiększany jest o pola sąsiadujące z wierszem poprzednim i rozlewany
+ * w poziomie, aż przejście w obu kierunkach niczego nie zmieni.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] own           – bitmapa pól gracza,
+ * @param[in] start         – identyfikator pola gracza,
+ * @param[out] fill         – wiersze części, poza zakresem @p lo .. @p hi
+ *                            zerowe,
+ * @param[out] lo           – pierwszy wiersz części,
+ * @param[out] hi           – ostatni wiersz części.
+ * @return Liczba pól części.
+ */
+static uint64_t field_bits_fill(const board_t *b, const uint64_t *own,
+                                field_t start, uint64_t fill[BITS_SIDE],
+                                uint32_t *lo, uint32_t *hi) {
+    uint32_t x = FIELD_X(start), y = FIELD_Y(start);
+    memset(fill, 0, b->height * sizeof(uint64_t));
+    fill[y] = field_bits_spread((uint64_t) 1 << x, own[y]);
+    uint32_t first = y, last = y;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t r = first + 1; r < b->height; ++r) {
+            uint64_t row = field_bits_spread(fill[r] | (fill[r - 1] & own[r]),
+                                             own[r]);
+            if (row != fill[r]) {
+                fill[r] = row;
+                changed = true;
+                last = r > last ? r : last;
+            } else if (r > last) {
+                break;
+            }
+        }
+        for (uint32_t r = last; r-- > 0;) {
+            uint64_t row = field_bits_spread(fill[r] | (fill[r + 1] & own[r]),
+                                             own[r]);
+            if (row != fill[r]) {
+                fill[r] = row;
+                changed = true;
+                first = r < first ? r : first;
+            } else if (r < first) {
+                break;
             }
-            result += add;
         }
     }
-    return result;
+    uint64_t count = 0;
+    for (uint32_t r = first; r <= last; ++r) {
+        count += (uint64_t) __builtin_popcountll(fill[r]);
+    }
+    *lo = first;
+    *hi = last;
+    return count;
 }
 
 
-void field_connect_area(field_t *field1, field_t *field2) {
-    if (ISNULL(field1) || ISNULL(field2)) {
-        return;
+/** @brief Przypisanie obszaru polom części wyznaczonej w trybie bitowym.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] fill          – wiersze części,
+ * @param[in] lo            – pierwszy wiersz części,
+ * @param[in] hi            – ostatni wiersz części,
+ * @param[in] to            – nowy identyfikator obszaru.
+ */
+static void field_bits_relabel(board_t *b, const uint64_t fill[BITS_SIDE],
+                               uint32_t lo, uint32_t hi, uint32_t to) {
+    for (uint32_t y = lo; y <= hi; ++y) {
+        for (uint64_t row = fill[y]; row != 0; row &= row - 1) {
+            field_t field = field_at((uint32_t) __builtin_ctzll(row), y);
+            struct cell slot = field_cell(b, field);
+            field_log_cell(b, slot, field);
+            *cell_area(slot) = to;
+        }
+    }
+}
+
+
+/** @brief Zajęcie wolnego pola w trybie bitowym.
+ * Pole dołącza do największego z sąsiednich obszarów gracza, a pozostałe
+ * sąsiednie obszary wyznaczane są operacjami na wierszach bitmapy
+ * i przepisywane do niego.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator wolnego pola,
+ * @param[in] player_id     – identyfikator gracza.
+ */
+static void field_bits_take(board_t *b, field_t field, uint32_t player_id) {
+    uint64_t *own = field_bits(b, player_id);
+    field_t adjoining[ADJOINING_FIELDS], starts[ADJOINING_FIELDS];
+    uint32_t areas[ADJOINING_FIELDS];
+    uint32_t count = 0, keep = 0;
+    uint32_t size = field_adjoining(b, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        if ((own[FIELD_Y(adjoining[i])] >> FIELD_X(adjoining[i]) & 1) == 0) {
+            continue;
+        }
+        uint32_t area = *cell_area(field_cell(b, adjoining[i]));
+        bool seen = false;
+        for (uint32_t j = 0; j < count; ++j) {
+            seen |= areas[j] == area;
+        }
+        if (!seen) {
+            if (count == 0 || b->areas[area].size > b->areas[keep].size) {
+                keep = area;
+            }
+            starts[count] = adjoining[i];
+            areas[count++] = area;
+        }
+    }
+    if (count == 0) {
+        keep = field_area_new(b);
+    } else {
+        field_log_area(b, keep);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (areas[i] == keep) {
+            continue;
+        }
+        uint64_t fill[BITS_SIDE];
+        uint32_t lo, hi;
+        field_bits_fill(b, own, starts[i], fill, &lo, &hi);
+        field_bits_relabel(b, fill, lo, hi, keep);
+        b->areas[keep].size += b->areas[areas[i]].size;
+        field_area_delete(b, areas[i]);
     }
-    struct area *area1 = &field1->area, *area2 = &field2->area;
-    if (area1->repr == area2->repr) {
+    struct cell slot = field_cell(b, field);
+    field_log_cell(b, slot, field);
+    own[FIELD_Y(field)] |= (uint64_t) 1 << FIELD_X(field);
+    owner_set(b, slot, player_id);
+    *cell_area(slot) = keep;
+    b->areas[keep].size++;
+    b->areas[keep].stale = true;
+    b->occupied++;
+}
+
+
+void field_take(board_t *b, field_t field, uint32_t player_id) {
+    if (b->bitboard) {
+        field_bits_take(b, field, player_id);
         return;
     }
-    if (area1->repr->size < area2->repr->size) {
-        struct area *tmp = area1;
-        area1 = area2;
-        area2 = tmp;
-    }
-    area1->repr->size += area2->repr->size;
-    area2->repr->size = 0;
-    struct area *curr = area2;
-    do {
-        curr->repr = area1->repr;
-        curr = curr->next;
-    } while (curr != area2);
-    struct area *next1 = area1->next;
-    struct area *prev2 = area2->prev;
-    area1->next = area2;
-    area2->prev = area1;
-    next1->prev = prev2;
-    prev2->next = next1;
-}
-
-
-void field_split_area(field_t *field) {
-    if (ISNULL(field)) {
+    field_t starts[ADJOINING_FIELDS];
+    uint32_t areas[ADJOINING_FIELDS], largest;
+    uint32_t count = field_adjoining_areas(b, field, player_id, starts, areas,
+                                           &largest);
+    uint32_t keep;
+    if (count == 0) {
+        keep = field_area_new(b);
+        field_box_set(b, keep, field);
+    } else {
+        /* Pozostałe obszary dołączane są do największego, więc identyfikator
+         * zmieniany jest tylko polom mniejszych obszarów. */
+        keep = areas[largest];
+        field_log_area(b, keep);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (i == largest) {
+                continue;
+            }
+            field_relabel(b, starts[i], player_id, areas[i], keep);
+            field_box_merge(b, keep, areas[i]);
+            b->areas[keep].size += b->areas[areas[i]].size;
+            field_area_delete(b, areas[i]);
+        }
+        field_box_add(b, keep, field);
+    }
+    struct cell slot = field_cell(b, field);
+    field_log_cell(b, slot, field);
+    owner_set(b, slot, player_id);
+    *cell_area(slot) = keep;
+    b->areas[keep].size++;
+    b->areas[keep].stale = true;
+    b->occupied++;
+}
+
+
+bool field_reserve_claims(board_t *b, uint64_t count) {
+    if (ISNULL(b) || b->sparse || b->bitboard || b->journal.enabled) {
+        return false;
+    }
+    /* Zajęcie pola przylegającego do obszaru gracza nie tworzy obszaru,
+     * więc wystarczy miejsce w kolejce algorytmu BFS. */
+    return field_queue_reserve(b, b->occupied + count);
+}
+
+
+uint32_t field_claim(board_t *b, field_t field, uint32_t player_id) {
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(b, field, adjoining);
+    uint32_t area = 0;
+    for (uint32_t i = 0; i < size && area == 0; ++i) {
+        struct cell slot = field_cell(b, adjoining[i]);
+        if (owner_get(b, slot) == player_id) {
+            area = *cell_area(slot);
+        }
+    }
+    struct cell slot = field_cell(b, field);
+    owner_set(b, slot, player_id);
+    *cell_area(slot) = area;
+    return area;
+}
+
+
+void field_claim_finish(board_t *b, uint32_t area) {
+    b->areas[area].size++;
+    b->areas[area].stale = true;
+    b->occupied++;
+}
+
+
+/** @brief Reprezentant grupy przeszukiwań.
+ * @param[in] group         – tablica rodziców w strukturze zbiorów rozłącznych,
+ * @param[in] search        – numer przeszukiwania.
+ * @return Numer przeszukiwania reprezentującego grupę @p search.
+ */
+static uint32_t field_search_find(const uint32_t group[ADJOINING_FIELDS],
+                                  uint32_t search) {
+    while (group[search] != search) {
+        search = group[search];
+    }
+    return search;
+}
+
+
+/** @brief Numer przeszukiwania, które odwiedziło pole.
+ * @param[in] label         – tymczasowe identyfikatory obszarów przeszukiwań,
+ * @param[in] searches      – liczba przeszukiwań,
+ * @param[in] area          – identyfikator obszaru pola.
+ * @return Numer przeszukiwania lub @ref ADJOINING_FIELDS, jeżeli pole nie
+ * zostało odwiedzone.
+ */
+static uint32_t field_search_of(const uint32_t label[ADJOINING_FIELDS],
+                                uint32_t searches, uint32_t area) {
+    for (uint32_t i = 0; i < searches; ++i) {
+        if (label[i] == area) {
+            return i;
+        }
+    }
+    return ADJOINING_FIELDS;
+}
+
+
+/** @brief Podział obszaru po usunięciu z niego pola.
+ * Z każdego sąsiada usuniętego pola należącego do obszaru @p old_area
+ * uruchamiane jest przeszukiwanie wszerz; wszystkie przeszukiwania postępują
+ * naprzemiennie we wspólnej kolejce. Przeszukiwania, które się spotkają,
+ * łączone są w grupę, a grupa, której kolejka się wyczerpie, stanowi kompletną
+ * oderwaną część obszaru. Algorytm kończy się, gdy co najwyżej jedna grupa
+ * pozostaje niedokończona – ta zachowuje identyfikator @p old_area i nie jest
+ * przechodzona do końca. Koszt jest więc proporcjonalny do rozmiaru
+ * mniejszych części, a nie całego obszaru.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator zwolnionego pola,
+ * @param[in] player_id     – identyfikator gracza, do którego należał obszar,
+ * @param[in] old_area      – identyfikator dzielonego obszaru.
+ */
+static void field_split_area(board_t *b, field_t field, uint32_t player_id,
+                             uint32_t old_area) {
+    uint32_t label[ADJOINING_FIELDS], group[ADJOINING_FIELDS];
+    uint64_t pending[ADJOINING_FIELDS], size[ADJOINING_FIELDS];
+    uint32_t searches = 0;
+    uint64_t head = 0, tail = 0;
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t adjoining_size = field_adjoining(b, field, adjoining);
+    for (uint32_t i = 0; i < adjoining_size; ++i) {
+        struct cell slot = field_cell(b, adjoining[i]);
+        if (owner_get(b, slot) == player_id && *cell_area(slot) == old_area) {
+            label[searches] = field_area_new(b);
+            if (b->sparse) {
+                b->boxes[label[searches]] = b->boxes[old_area];
+            }
+            group[searches] = searches;
+            pending[searches] = 1;
+            size[searches] = 0;
+            field_log_cell(b, slot, adjoining[i]);
+            *cell_area(slot) = label[searches];
+            b->queue[tail++] = adjoining[i];
+            searches++;
+        }
+    }
+    uint32_t running = searches;
+    while (running > 1) {
+        field_t current = b->queue[head++];
+        uint32_t root = field_search_find(group, field_search_of(
+                label, searches, *cell_area(field_cell(b, current))));
+        field_t next[ADJOINING_FIELDS];
+        uint32_t next_size = field_adjoining(b, current, next);
+        for (uint32_t i = 0; i < next_size; ++i) {
+            struct cell slot = field_cell(b, next[i]);
+            if (owner_get(b, slot) != player_id) {
+                continue;
+            }
+            if (*cell_area(slot) == old_area) {
+                field_log_cell(b, slot, next[i]);
+                *cell_area(slot) = label[root];
+                b->queue[tail++] = next[i];
+                pending[root]++;
+                continue;
+            }
+            uint32_t other = field_search_find(group, field_search_of(
+                    label, searches, *cell_area(slot)));
+            if (other != root) {
+                /* Przeszukiwania się spotkały: to ta sama część obszaru. */
+                group[other] = root;
+                pending[root] += pending[other];
+                running--;
+            }
+        }
+        if (--pending[root] == 0) {
+            running--;
+        }
+    }
+    /* Grupy z pustą kolejką dostają nowe obszary, a pola odwiedzone przez
+     * niedokończoną grupę wracają do dawnego obszaru. */
+    for (uint64_t i = 0; i < tail; ++i) {
+        struct cell slot = field_cell(b, b->queue[i]);
+        uint32_t root = field_search_find(group, field_search_of(
+                label, searches, *cell_area(slot)));
+        field_log_cell(b, slot, b->queue[i]);
+        if (pending[root] == 0) {
+            *cell_area(slot) = label[root];
+            size[root]++;
+        } else {
+            *cell_area(slot) = old_area;
+        }
+    }
+    uint64_t detached = 0;
+    bool old_area_used = false;
+    for (uint32_t i = 0; i < searches; ++i) {
+        if (group[i] == i && pending[i] == 0) {
+            b->areas[label[i]].size = size[i];
+            detached += size[i];
+        } else {
+            old_area_used |= group[i] == i;
+            field_area_delete(b, label[i]);
+        }
+    }
+    if (old_area_used) {
+        field_log_area(b, old_area);
+        b->areas[old_area].size -= 1 + detached;
+        b->areas[old_area].stale = true;
+    } else {
+        field_area_delete(b, old_area);
+    }
+}
+
+
+/** @brief Podział obszaru bez danego pola w trybie bitowym.
+ * Części obszaru wyznaczane są operacjami na wierszach bitmapy, aż wszyscy
+ * sąsiedzi pola należący do obszaru zostaną przydzieleni do którejś z nich.
+ * Ostatniej części nie trzeba wyznaczać, jej rozmiar wynika z rozmiaru
+ * obszaru.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] own           – bitmapa pól gracza bez pola @p field,
+ * @param[in] field         – identyfikator pola,
+ * @param[out] fill         – wiersze wyznaczonych części,
+ * @param[out] pieces       – liczby pól wyznaczonych części,
+ * @param[out] lo           – pierwsze wiersze wyznaczonych części,
+ * @param[out] hi           – ostatnie wiersze wyznaczonych części,
+ * @param[in, out] rest     – liczba pól obszaru bez pola @p field; zostaje
+ *                            w niej liczba pól niewyznaczonej części lub `0`.
+ * @return Liczba wyznaczonych części.
+ */
+static uint32_t field_bits_split(const board_t *b, const uint64_t *own,
+                                 field_t field,
+                                 uint64_t fill[ADJOINING_FIELDS][BITS_SIDE],
+                                 uint64_t pieces[ADJOINING_FIELDS],
+                                 uint32_t lo[ADJOINING_FIELDS],
+                                 uint32_t hi[ADJOINING_FIELDS],
+                                 uint64_t *rest) {
+    field_t adjoining[ADJOINING_FIELDS], starts[ADJOINING_FIELDS];
+    uint32_t count = 0, filled = 0;
+    uint32_t size = field_adjoining(b, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        if (own[FIELD_Y(adjoining[i])] >> FIELD_X(adjoining[i]) & 1) {
+            starts[count++] = adjoining[i];
+        }
+    }
+    bool covered[ADJOINING_FIELDS] = { false };
+    for (uint32_t i = 0; i < count; ++i) {
+        bool last = true;
+        for (uint32_t j = i + 1; j < count; ++j) {
+            last &= covered[j];
+        }
+        if (covered[i] || last) {
+            continue;
+        }
+        pieces[filled] = field_bits_fill(b, own, starts[i], fill[filled],
+                                         &lo[filled], &hi[filled]);
+        *rest -= pieces[filled];
+        for (uint32_t j = i + 1; j < count; ++j) {
+            covered[j] |= (fill[filled][FIELD_Y(starts[j])]
+                           >> FIELD_X(starts[j]) & 1) != 0;
+        }
+        filled++;
+    }
+    return filled;
+}
+
+
+/** @brief Zwolnienie zajętego pola w trybie bitowym.
+ * Niewyznaczona przez @ref field_bits_split część obszaru (lub największa,
+ * jeżeli wyznaczone są wszystkie) zachowuje identyfikator obszaru,
+ * a pozostałe dostają nowe.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator zajętego pola.
+ */
+static void field_bits_release(board_t *b, field_t field) {
+    struct cell slot = field_cell(b, field);
+    uint32_t player_id = owner_get(b, slot);
+    uint32_t old_area = *cell_area(slot);
+    uint64_t *own = field_bits(b, player_id);
+    field_log_cell(b, slot, field);
+    field_log_area(b, old_area);
+    own[FIELD_Y(field)] &= ~((uint64_t) 1 << FIELD_X(field));
+    owner_set(b, slot, 0);
+    *cell_area(slot) = 0;
+    b->occupied--;
+    if (--b->areas[old_area].size == 0) {
+        field_area_delete(b, old_area);
         return;
     }
-    struct area *area = &field->area;
-    if (area->repr == area && area->size == 1) {
+    b->areas[old_area].stale = true;
+    uint64_t fill[ADJOINING_FIELDS][BITS_SIDE], pieces[ADJOINING_FIELDS];
+    uint32_t lo[ADJOINING_FIELDS], hi[ADJOINING_FIELDS];
+    uint64_t rest = b->areas[old_area].size;
+    uint32_t filled = field_bits_split(b, own, field, fill, pieces, lo, hi,
+                                       &rest);
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < filled; ++i) {
+        if (pieces[i] > pieces[largest]) {
+            largest = i;
+        }
+    }
+    for (uint32_t i = 0; i < filled; ++i) {
+        if (rest == 0 && i == largest) {
+            continue;
+        }
+        uint32_t id = field_area_new(b);
+        field_bits_relabel(b, fill[i], lo[i], hi[i], id);
+        b->areas[id].size = pieces[i];
+        b->areas[old_area].size -= pieces[i];
+    }
+}
+
+
+/** @brief Zliczenie części obszaru po zwolnieniu pola w trybie bitowym.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator zajętego pola.
+ * @return Liczba części na które rozpadnie się obszar pola @p field
+ * po jego zwolnieniu.
+ */
+static uint32_t field_bits_pieces(board_t *b, field_t field) {
+    struct cell slot = field_cell(b, field);
+    uint64_t *own = field_bits(b, owner_get(b, slot));
+    uint64_t bit = (uint64_t) 1 << FIELD_X(field);
+    uint64_t fill[ADJOINING_FIELDS][BITS_SIDE], pieces[ADJOINING_FIELDS];
+    uint32_t lo[ADJOINING_FIELDS], hi[ADJOINING_FIELDS];
+    uint64_t rest = b->areas[*cell_area(slot)].size - 1;
+    own[FIELD_Y(field)] &= ~bit;
+    uint32_t filled = field_bits_split(b, own, field, fill, pieces, lo, hi,
+                                       &rest);
+    own[FIELD_Y(field)] |= bit;
+    return filled + (rest > 0);
+}
+
+
+void field_release(board_t *b, field_t field) {
+    if (b->bitboard) {
+        field_bits_release(b, field);
         return;
     }
-    struct area *temp_next, *current = area;
-    do {
-        temp_next = current->next;
-        current->next = current;
-        current->prev = current;
-        current->repr = current;
-        current->size = 1;
-        current = temp_next;
-    } while (current != area);
+    struct cell slot = field_cell(b, field);
+    uint32_t player_id = owner_get(b, slot);
+    uint32_t old_area = *cell_area(slot);
+    field_log_cell(b, slot, field);
+    owner_set(b, slot, 0);
+    *cell_area(slot) = 0;
+    b->occupied--;
+    field_split_area(b, field, player_id, old_area);
+}
+
+
+uint32_t field_count_adjoining_areas(const board_t *b, field_t field,
+                                     uint32_t player_id) {
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t areas[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(b, field, adjoining);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        struct cell slot = field_cell(b, adjoining[i]);
+        if (owner_get(b, slot) == player_id) {
+            bool add = true;
+            for (uint32_t j = 0; j < result; ++j) {
+                if (areas[j] == *cell_area(slot)) {
+                    add = false;
+                    break;
+                }
+            }
+            if (add) {
+                areas[result++] = *cell_area(slot);
+            }
+        }
+    }
+    return result;
 }
 
 
-uint32_t field_count_adjoining_areas_after_breaking(field_t *field) {
-    uint32_t player = field->owner;
+/** @brief Zliczenie części obszaru po zwolnieniu pola algorytmem BFS.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola.
+ * @return Liczba części na które rozpadnie się obszar pola @p field
+ * po jego zwolnieniu.
+ */
+static uint32_t field_count_pieces(board_t *b, field_t field) {
+    struct cell slot = field_cell(b, field);
+    uint32_t player = owner_get(b, slot);
     uint32_t result = 0;
-    field->visited = true;
-    field_t *queue = NULL;
-    field_t *reset = NULL;
-    for (uint32_t i = 0; i < field->size_adjoining; ++i) {
-        if (field->adjoining[i]->owner != player
-                || field->adjoining[i]->visited) {
+    uint64_t head = 0, tail = 0;
+    cell_toggle_visited(slot);
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(b, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        struct cell adj_slot = field_cell(b, adjoining[i]);
+        if (owner_get(b, adj_slot) != player || cell_visited(adj_slot)) {
             continue;
         }
-        field->adjoining[i]->visited = true;
-        field->adjoining[i]->next_node = queue;
-        queue = field->adjoining[i];
-        while (!ISNULL(queue)) {
-            field_t *curr = queue;
-            queue = queue->next_node;
-            curr->next_node = reset;
-            reset = curr;
-            for (uint32_t j = 0; j < curr->size_adjoining; ++j) {
-                if (curr->adjoining[j]->visited ||
-                    curr->adjoining[j]->owner != player) {
+        cell_toggle_visited(adj_slot);
+        b->queue[tail++] = adjoining[i];
+        while (head < tail) {
+            field_t next[ADJOINING_FIELDS];
+            uint32_t next_size = field_adjoining(b, b->queue[head++], next);
+            for (uint32_t j = 0; j < next_size; ++j) {
+                struct cell next_slot = field_cell(b, next[j]);
+                if (owner_get(b, next_slot) != player
+                        || cell_visited(next_slot)) {
                     continue;
                 }
-                curr->adjoining[j]->visited = true;
-                curr->adjoining[j]->next_node = queue;
-                queue = curr->adjoining[j];
+                cell_toggle_visited(next_slot);
+                b->queue[tail++] = next[j];
             }
         }
         result++;
     }
-    while (!ISNULL(reset)) {
-        field_t *curr = reset;
-        reset = reset->next_node;
-        curr->visited = false;
-        curr->next_node = NULL;
+    for (uint64_t i = 0; i < tail; ++i) {
+        cell_toggle_visited(field_cell(b, b->queue[i]));
     }
-    field->visited = false;
+    cell_toggle_visited(slot);
     return result;
 }
 
 
-uint32_t field_count_adjoining_fields(const field_t *field, uint32_t player_id) {
-    if (ISNULL(field) || player_id == 0) {
+/** @brief Wyznaczenie punktów artykulacji obszaru.
+ * Procedura przechodzi obszar iteracyjnym przeszukiwaniem w głąb (algorytm
+ * Tarjana) i dla każdego pola zapisuje, na ile części rozpadnie się obszar
+ * po jego zwolnieniu: korzeń drzewa przeszukiwania rozdziela tyle części,
+ * ile ma dzieci, a pozostałe pola – o jedną więcej niż liczba dzieci, z których
+ * poddrzew nie prowadzi krawędź powyżej pola.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] start         – identyfikator dowolnego pola obszaru,
+ * @param[in] area_id       – identyfikator obszaru.
+ * @return Wartość @p true, jeżeli udało się wyznaczyć punkty artykulacji,
+ * @p false jeżeli zabrakło pamięci na stos lub obszar jest zbyt duży.
+ */
+static bool field_compute_pieces(board_t *b, field_t start, uint32_t area_id) {
+    uint64_t size = b->areas[area_id].size;
+    if (size >= UINT32_MAX) {
+        return false;
+    }
+    if (b->dfs_capacity < size) {
+        struct dfs_frame *dfs = realloc(b->dfs, size * sizeof(struct dfs_frame));
+        if (ISNULL(dfs)) {
+            return false;
+        }
+        b->dfs = dfs;
+        b->dfs_capacity = size;
+    }
+    if (b->dfs_clock > UINT32_MAX - size) {
+        /* Numery odwiedzenia się wyczerpały – zaczynamy od nowa. */
+        if (!field_unshare_all(b)) {
+            return false;
+        }
+        if (b->sparse) {
+            for (uint64_t i = 0; i < b->used_size; ++i) {
+                memset(b->tiles[b->used[i]]->order, 0,
+                       TILE_FIELDS * sizeof(uint32_t));
+            }
+        } else {
+            memset(b->tiles[0]->order, 0,
+                   field_dense_fields(b) * sizeof(uint32_t));
+        }
+        b->dfs_clock = 0;
+    }
+    /* Pola o numerze odwiedzenia nie większym niż base nie zostały jeszcze
+     * odwiedzone w tym przeszukiwaniu. */
+    uint32_t base = b->dfs_clock;
+    uint32_t player = owner_get(b, field_cell(b, start));
+    uint64_t top = 0;
+    struct cell start_slot = field_cell(b, start);
+    *cell_order(start_slot) = ++b->dfs_clock;
+    *cell_pieces(start_slot) = 0;
+    b->dfs[top++] = (struct dfs_frame) { .field = start,
+                                         .low = b->dfs_clock, .next = 0 };
+    while (top > 0) {
+        struct dfs_frame *frame = &b->dfs[top - 1];
+        field_t adjoining[ADJOINING_FIELDS];
+        uint32_t adjoining_size = field_adjoining(b, frame->field, adjoining);
+        if (frame->next < adjoining_size) {
+            field_t next = adjoining[frame->next++];
+            struct cell slot = field_cell(b, next);
+            if (owner_get(b, slot) != player) {
+                continue;
+            }
+            if (*cell_order(slot) > base) {
+                if (*cell_order(slot) < frame->low) {
+                    frame->low = *cell_order(slot);
+                }
+            } else {
+                *cell_order(slot) = ++b->dfs_clock;
+                *cell_pieces(slot) = 1;
+                b->dfs[top++] = (struct dfs_frame) { .field = next,
+                                                     .low = b->dfs_clock,
+                                                     .next = 0 };
+            }
+        } else {
+            uint32_t low = frame->low;
+            top--;
+            if (top > 0) {
+                struct dfs_frame *parent = &b->dfs[top - 1];
+                struct cell parent_slot = field_cell(b, parent->field);
+                if (low < parent->low) {
+                    parent->low = low;
+                }
+                if (low >= *cell_order(parent_slot)) {
+                    (*cell_pieces(parent_slot))++;
+                }
+            }
+        }
+    }
+    b->areas[area_id].stale = false;
+    return true;
+}
+
+
+uint32_t field_count_adjoining_areas_after_breaking(board_t *b, field_t field) {
+    uint32_t area_id = *cell_area(field_cell(b, field));
+    if (b->bitboard) {
+        /* Wyznaczenie części kosztuje kilka przejść po wierszach bitmapy,
+         * mniej niż ponowne wyznaczanie punktów artykulacji po każdej
+         * zmianie obszaru. */
+        return field_bits_pieces(b, field);
+    }
+    /* Przeszukiwanie wszerz przywraca bitmapę odwiedzonych pól, więc
+     * nie zmienia fragmentów, których nie udało się skopiować. */
+    if (b->areas[area_id].stale
+            && (!field_area_unshare(b, area_id)
+                || !field_compute_pieces(b, field, area_id))) {
+        return field_count_pieces(b, field);
+    }
+    /* Skopiowanie fragmentów mogło przenieść pole. */
+    return *cell_pieces(field_cell(b, field));
+}
+
+
+uint32_t field_count_adjoining_fields(const board_t *b, field_t field,
+                                      uint32_t player_id) {
+    if (ISNULL(b) || field == FIELD_NONE || player_id == 0) {
         return 0;
     }
+    if (b->bitboard) {
+        if (player_id > b->players) {
+            return 0;
+        }
+        const uint64_t *own = field_bits(b, player_id);
+        uint32_t x = FIELD_X(field), y = FIELD_Y(field);
+        uint64_t near = ((uint64_t) 1 << x >> 1) | ((uint64_t) 1 << x << 1);
+        return (uint32_t) __builtin_popcountll(own[y] & near)
+               + (y > 0 ? (uint32_t) (own[y - 1] >> x & 1) : 0)
+               + (y + 1 < b->height ? (uint32_t) (own[y + 1] >> x & 1) : 0);
+    }
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(b, field, adjoining);
     uint32_t result = 0;
-    for (uint32_t i = 0; i < field->size_adjoining; ++i) {
-        if (field->adjoining[i]->owner == player_id) {
+    for (uint32_t i = 0; i < size; ++i) {
+        if (owner_get(b, field_cell(b, adjoining[i])) == player_id) {
             result++;
         }
     }
@@ -255,38 +2389,110 @@ uint32_t field_count_adjoining_fields(const field_t *field, uint32_t player_id)
 }
 
 
-void field_rebuild_areas_around(field_t *field, uint32_t player_id) {
-    field_t *queue = NULL;
-    field_t *reset = NULL;
-    for (uint32_t i = 0; i < field->size_adjoining; ++i) {
-        if (field->adjoining[i]->owner != player_id ||
-            field->adjoining[i]->visited) {
-            continue;
+bool field_journal_start(board_t *b) {
+    if (ISNULL(b)) {
+        return false;
+    }
+    b->journal.changes_size = 0;
+    b->journal.cells_size = 0;
+    b->journal.areas_size = 0;
+    b->journal.enabled = true;
+    b->journal.open = false;
+    return true;
+}
+
+
+void field_journal_stop(board_t *b) {
+    if (!ISNULL(b)) {
+        field_journal_lose(b);
+        b->journal.enabled = false;
+    }
+}
+
+
+bool field_journal_begin(board_t *b) {
+    if (ISNULL(b) || !b->journal.enabled) {
+        return false;
+    }
+    struct journal *j = &b->journal;
+    if (!field_journal_grow((void **) &j->changes, &j->changes_capacity,
+                            j->changes_size, sizeof(struct journal_change))) {
+        field_journal_lose(b);
+        return false;
+    }
+    j->changes[j->changes_size++] = (struct journal_change) {
+            .cells = j->cells_size, .areas = j->areas_size,
+            .occupied = b->occupied, .areas_used = b->areas_used,
+            .free_area = b->free_area };
+    j->open = true;
+    return true;
+}
+
+
+uint64_t field_journal_changes(const board_t *b) {
+    return ISNULL(b) ? 0 : b->journal.changes_size;
+}
+
+
+/** @brief Skopiowanie współdzielonych fragmentów zapisanych w zmianie.
+ * @param[in, out] b        – wskaźnik na planszę w trybie rzadkim,
+ * @param[in] first         – pierwszy zapis pola zmiany.
+ * @return Wartość @p true jeżeli żaden fragment zawierający pola zmiany nie
+ * jest już współdzielony, @p false jeżeli zabrakło pamięci.
+ */
+static bool field_journal_unshare(board_t *b, uint64_t first) {
+    for (uint64_t i = first; i < b->journal.cells_size && b->shared > 0; ++i) {
+        uint64_t index = field_tile_index(b, b->journal.cells[i].field);
+        if ((b->shared_map[index / WORD_BITS] >> (index % WORD_BITS) & 1)
+                && !field_tile_unshare(b, index)) {
+            return false;
         }
-        field->adjoining[i]->visited = true;
-        field->adjoining[i]->next_node = queue;
-        queue = field->adjoining[i];
-        while (!ISNULL(queue)) {
-            field_t *curr = queue;
-            queue = queue->next_node;
-            curr->next_node = reset;
-            reset = curr;
-            field_connect_area(curr, field->adjoining[i]);
-            for (uint32_t j = 0; j < curr->size_adjoining; ++j) {
-                if (curr->adjoining[j]->visited ||
-                    curr->adjoining[j]->owner != player_id) {
-                    continue;
-                }
-                curr->adjoining[j]->visited = true;
-                curr->adjoining[j]->next_node = queue;
-                queue = curr->adjoining[j];
+    }
+    return true;
+}
+
+
+bool field_journal_undo(board_t *b) {
+    if (ISNULL(b) || b->journal.changes_size == 0) {
+        return false;
+    }
+    struct journal *j = &b->journal;
+    struct journal_change change = j->changes[j->changes_size - 1];
+    if (b->sparse && !field_journal_unshare(b, change.cells)) {
+        return false;
+    }
+    for (uint64_t i = j->cells_size; i-- > change.cells;) {
+        const struct journal_cell *entry = &j->cells[i];
+        struct cell slot = field_cell(b, entry->field);
+        uint32_t owner = owner_get(b, slot);
+        if (b->bitboard && owner != entry->owner) {
+            uint64_t bit = (uint64_t) 1 << FIELD_X(entry->field);
+            if (owner != 0) {
+                field_bits(b, owner)[FIELD_Y(entry->field)] &= ~bit;
+            }
+            if (entry->owner != 0) {
+                field_bits(b, entry->owner)[FIELD_Y(entry->field)] |= bit;
             }
         }
+        owner_set(b, slot, entry->owner);
+        *cell_area(slot) = entry->area;
     }
-    while (!ISNULL(reset)) {
-        field_t *curr = reset;
-        reset = reset->next_node;
-        curr->next_node = NULL;
-        curr->visited = false;
+    /* Punkty artykulacji odtworzonych obszarów mogły zostać wyznaczone dla
+     * ich późniejszego kształtu. */
+    for (uint64_t i = j->areas_size; i-- > change.areas;) {
+        const struct journal_area *entry = &j->areas[i];
+        b->areas[entry->id] = entry->area;
+        b->areas[entry->id].stale = true;
+        if (b->sparse) {
+            b->boxes[entry->id] = entry->box;
+        }
     }
+    b->occupied = change.occupied;
+    b->areas_used = change.areas_used;
+    b->free_area = change.free_area;
+    j->cells_size = change.cells;
+    j->areas_size = change.areas;
+    j->changes_size--;
+    j->open = false;
+    return true;
 }
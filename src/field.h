@@ -1,5 +1,5 @@
 /** @file
- * Definicja pola na planszy gry Gamma oraz deklaracja związanych z nim funkcji.
+ * Definicja planszy gry Gamma oraz deklaracja funkcji operujących na jej polach.
  *
  * @author Adam Rozenek <adam.rozenek@students.mimuw.edu.pl>
  * @date 17.05.2020
@@ -16,119 +16,420 @@
 #define ADJOINING_FIELDS 4
 
 
-/** Struktura przechowująca informacje o pojedyńczym polu w grze.
+/** Wartość oznaczająca brak pola (np. niepoprawne współrzędne). */
+#define FIELD_NONE UINT64_MAX
+
+
+/** @brief Identyfikator pola na planszy.
+ * Współrzędne pola spakowane w jedną liczbę: numer wiersza w starszych
+ * 32 bitach, numer kolumny w młodszych. Sąsiedzi pola wyznaczani są
+ * bezpośrednio z identyfikatora, bez przechowywania wskaźników.
+ */
+typedef uint64_t field_t;
+
+
+/** Struktura przechowująca planszę gry: właścicieli pól oraz obszary.
+ */
+typedef struct board board_t;
+
+
+/** Sposób przechowywania pól planszy.
+ */
+typedef enum board_storage {
+    BOARD_STORAGE_AUTO, /**< Sposób dobierany do rozmiaru planszy. */
+    BOARD_STORAGE_DENSE, /**< Jedna płaska tablica wszystkich pól. */
+    BOARD_STORAGE_SPARSE, /**< Fragmenty planszy tworzone dopiero przy zajęciu
+                           * pierwszego pola, brakujące fragmenty oznaczają
+                           * wolne pola. */
+    BOARD_STORAGE_BITS /**< Tryb gęsty z dodatkową bitmapą pól każdego
+                        * gracza, po jednym słowie na wiersz. Łączenie
+                        * i dzielenie obszarów wykonywane jest operacjami na
+                        * całych wierszach. Dostępny dla plansz o bokach nie
+                        * większych niż 64 i co najwyżej 64 graczy, dla
+                        * pozostałych oznacza tryb gęsty. */
+} board_storage_t;
+
+
+/** Układ pól planszy w pamięci.
+ */
+typedef enum board_layout {
+    BOARD_LAYOUT_ROWS, /**< Kolejne wiersze planszy (lub fragmentu). */
+    BOARD_LAYOUT_SQUARES /**< Kwadraty 8 na 8 pól, w kwadracie kolejne
+                          * wiersze. Pole i jego sąsiedzi z sąsiednich wierszy
+                          * leżą zwykle w tym samym kwadracie, więc
+                          * przeszukiwania planszy trafiają do pamięci
+                          * podręcznej. Szerokość planszy zaokrąglana jest
+                          * do wielokrotności 8. */
+} board_layout_t;
+
+
+/** @brief Identyfikator pola o podanych współrzędnych.
+ * @param[in] x             – numer kolumny,
+ * @param[in] y             – numer wiersza.
+ * @return Identyfikator pola (@p x, @p y).
+ */
+field_t field_at(uint32_t x, uint32_t y);
+
+
+/** @brief Numer kolumny pola.
+ * @param[in] field         – identyfikator pola.
+ * @return Numer kolumny pola @p field.
+ */
+uint32_t field_column(field_t field);
+
+
+/** @brief Numer wiersza pola.
+ * @param[in] field         – identyfikator pola.
+ * @return Numer wiersza pola @p field.
  */
-typedef struct field field_t;
+uint32_t field_row(field_t field);
+
+
+/** @brief Rozmiar bloku pamięci planszy.
+ * Funkcja podaje rozmiar bloku pamięci potrzebnego funkcji
+ * @ref field_board_init. Na jedno pole przypada kilka bajtów pamięci.
+ * Identyfikatory właścicieli pól zapisywane są na 1, 2 lub 4 bajtach,
+ * w zależności od liczby graczy. W trybie rzadkim blok zawiera jedynie
+ * tablicę fragmentów planszy, a same fragmenty przydzielane są dopiero przy
+ * zajęciu w nich pierwszego pola. W trybie bitowym blok zawiera dodatkowo
+ * po słowie na każdy wiersz planszy i każdego gracza.
+ * @param[in] width         – ilość kolumn,
+ * @param[in] height        – ilość wierszy,
+ * @param[in] players       – liczba graczy,
+ * @param[in] storage       – sposób przechowywania pól,
+ * @param[in] layout        – układ pól w pamięci.
+ * @return Rozmiar bloku w bajtach lub `0`, jeżeli któryś z parametrów jest
+ * zerem lub plansza nie zmieści się w przestrzeni adresowej.
+ */
+uint64_t field_board_size(uint32_t width, uint32_t height, uint32_t players,
+                          board_storage_t storage, board_layout_t layout);
+
+
+/** @brief Tworzy planszę w podanym bloku pamięci.
+ * Funkcja tworzy planszę gry Gamma o wielkości `width * height`, na której
+ * wszystkie pola są wolne. Stan początkowy wszystkich pól to same zera, więc
+ * czas tworzenia planszy nie zależy od jej rozmiaru. Tablice pól leżą
+ * na początku bloku, więc mają jego wyrównanie.
+ * @param[in] memory        – wyzerowany blok pamięci o rozmiarze podanym przez
+ *                            @ref field_board_size dla tych samych parametrów,
+ * @param[in] width         – ilość kolumn,
+ * @param[in] height        – ilość wierszy,
+ * @param[in] players       – liczba graczy,
+ * @param[in] storage       – sposób przechowywania pól,
+ * @param[in] layout        – układ pól w pamięci.
+ * @return Wskaźnik do utworzonej planszy (leżący w bloku @p memory) lub
+ * `NULL`, jeżeli któryś z parametrów jest niepoprawny.
+ */
+board_t *field_board_init(void *memory, uint32_t width, uint32_t height,
+                          uint32_t players, board_storage_t storage,
+                          board_layout_t layout);
+
+
+/** @brief Tworzy planszę przechowywaną w pliku.
+ * Funkcja tworzy (lub nadpisuje) plik @p path i mapuje go do pamięci. Tablice
+ * pól w układzie trybu gęstego i tablica obszarów znajdują się w pliku, więc
+ * plansza może być większa niż pamięć operacyjna – system operacyjny usuwa
+ * z pamięci rzadko używane strony. Przed tablicami plik zawiera
+ * @p extra_size bajtów danych użytkownika (@ref field_board_extra). Plik jest
+ * w formacie bieżącej architektury.
+ * @param[in] width         – ilość kolumn,
+ * @param[in] height        – ilość wierszy,
+ * @param[in] players       – liczba graczy,
+ * @param[in] layout        – układ pól w pamięci,
+ * @param[in] path          – ścieżka do pliku,
+ * @param[in] extra_size    – rozmiar danych użytkownika w bajtach.
+ * @return Wskaźnik do utworzonej planszy lub `NULL` jeżeli nie udało się
+ * utworzyć pliku lub któryś z parametrów jest niepoprawny.
+ */
+board_t *field_board_map(uint32_t width, uint32_t height, uint32_t players,
+                         board_layout_t layout, const char *path,
+                         uint64_t extra_size);
+
+
+/** @brief Otwiera planszę zapisaną w pliku.
+ * Funkcja mapuje do pamięci plik utworzony przez @ref field_board_map
+ * i zamknięty funkcją @ref field_board_delete. Zmiany planszy zapisywane
+ * są w tym samym pliku, chyba że plik otwarto tylko do odczytu – wtedy
+ * zmiany widoczne są tylko w pamięci procesu, a plik może być jednocześnie
+ * otwarty w ten sposób wielokrotnie. Czas otwarcia nie zależy od rozmiaru
+ * planszy.
+ * @param[in] path          – ścieżka do pliku,
+ * @param[in] read_only     – @p true, jeżeli plik ma być otwarty tylko
+ *                            do odczytu.
+ * @return Wskaźnik do planszy lub `NULL` jeżeli nie udało się otworzyć pliku,
+ * plik nie zawiera planszy lub nie został poprawnie zamknięty.
+ */
+board_t *field_board_open(const char *path, bool read_only);
+
+
+/** @brief Dane użytkownika zapisane w pliku planszy.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[out] size         – rozmiar danych w bajtach lub `NULL`.
+ * @return Wskaźnik na dane (wyrównany do 64 bajtów) lub `NULL` jeżeli plansza
+ * nie jest przechowywana w pliku.
+ */
+void *field_board_extra(const board_t *b, uint64_t *size);
+
+
+/** @brief Sposób przechowywania pól planszy.
+ * @param[in] b             – wskaźnik na planszę.
+ * @return Sposób przechowywania pól; plansza w pliku ma tryb gęsty.
+ */
+board_storage_t field_board_storage(const board_t *b);
+
+
+/** @brief Układ pól planszy w pamięci.
+ * @param[in] b             – wskaźnik na planszę.
+ * @return Układ pól planszy.
+ */
+board_layout_t field_board_layout(const board_t *b);
+
+
+/** @brief Kopiuje stan planszy.
+ * Plansza @p b musi być pustą planszą w pamięci, utworzoną funkcją
+ * @ref field_board_init dla wymiarów, liczby graczy, sposobu przechowywania
+ * i układu pól planszy @p source. W trybie rzadkim fragmenty planszy są
+ * współdzielone przez obie plansze i kopiowane dopiero przed pierwszą zmianą
+ * (w @ref field_reserve lub przy wyznaczaniu punktów artykulacji), więc koszt
+ * kopii zależy od liczby fragmentów, a nie pól. W pozostałych trybach tablice
+ * pól są kopiowane od razu.
+ * @param[in, out] b        – wskaźnik na planszę docelową,
+ * @param[in, out] source   – wskaźnik na kopiowaną planszę.
+ * @return Wartość @p true jeżeli udało się skopiować planszę, @p false
+ * w przeciwnym wypadku (planszę @p b należy wtedy usunąć).
+ */
+bool field_board_copy(board_t *b, board_t *source);
+
+
+/** @brief Usuwa planszę.
+ * Nic nie robi, jeśli wskaźnik ma wartość `NULL`. Zwalnia pamięć przydzieloną
+ * w trakcie gry, ale nie blok podany funkcji @ref field_board_init. Plansza
+ * przechowywana w pliku zostaje w nim zapisana i może być ponownie otwarta
+ * funkcją @ref field_board_open.
+ * @param[in] b             – wskaźnik na usuwaną planszę.
+ */
+void field_board_delete(board_t *b);
+
+
+/** @brief Czyści planszę.
+ * Wszystkie pola stają się wolne, a dziennik zmian pusty. Tablice planszy
+ * i dziennika nie są zwalniane, więc mogą służyć kolejnej rozgrywce
+ * bez ponownego przydzielania pamięci. W trybie rzadkim zwalniane są tylko
+ * fragmenty współdzielone z kopiami planszy.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli plansza została wyczyszczona, @p false jeżeli
+ * wskaźnik ma wartość `NULL` lub plansza jest tylko do odczytu.
+ */
+bool field_board_reset(board_t *b);
 
 
 /** @brief Identyfikator gracza zajmującego pole.
- * @param[in] field         – wskaźnik na pole.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola.
  * @return Funkcja zwraca identyfikator gracza, którego pionek zajmuje pole lub
  * `0` jeżeli pole jest wolne.
  */
-uint32_t field_owner(const field_t *field);
+uint32_t field_owner(const board_t *b, field_t field);
+
+
+/** @brief Identyfikatory graczy zajmujących kolejne pola wiersza.
+ * Funkcja odczytuje właścicieli pól całymi odcinkami tablic planszy, a nie
+ * pole po polu.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] x             – numer kolumny pierwszego pola,
+ * @param[in] y             – numer wiersza,
+ * @param[in] count         – liczba pól, `x + count` nie większe od
+ *                            szerokości planszy,
+ * @param[out] owners       – tablica, do której zostaną zapisane
+ *                            identyfikatory graczy (`0` dla wolnych pól).
+ */
+void field_owners(const board_t *b, uint32_t x, uint32_t y, uint32_t count,
+                  uint32_t *owners);
 
 
-/** @brief Ustawienie identyfikatora gracza zajmującego pole.
- * @param[in, out] field    – wskaźnika na pole,
- * @param[in] new_owner     – identyfikator gracza lub `0` jeżeli pole ma zostać
- *                            zwolnione.
+/** @brief Tablica właścicieli pól w układzie wierszowym.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[out] owner_size   – rozmiar identyfikatora właściciela w bajtach,
+ * @param[out] stride       – odległość kolejnych wierszy w elementach.
+ * @return Wskaźnik na właściciela pola (0, 0) lub `NULL`, jeżeli plansza nie
+ * jest jedną tablicą w układzie wierszowym.
  */
-void field_set_owner(field_t *field, uint32_t new_owner);
+const void *field_owners_array(const board_t *b, uint32_t *owner_size,
+                               uint64_t *stride);
+
+
+/** @brief Identyfikatory graczy zajmujących pola z listy.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] fields        – identyfikatory pól planszy,
+ * @param[in] count         – liczba pól,
+ * @param[out] owners       – tablica, do której zostaną zapisane
+ *                            identyfikatory graczy (`0` dla wolnych pól).
+ */
+void field_gather(const board_t *b, const field_t *fields, uint64_t count,
+                  uint32_t *owners);
 
 
 /** @brief Tablica sąsiedztwa pola.
- * Funkcja wpisuje do tablicy podanej jako parametr @p adjoining wskaźniki pól
- * z którymi sąsiaduje pole @p field. Jeżeli @p field ma mniej niż czterech
- * sąsiadów, reszta tablicy uzupełniana jest wartościami `NULL`.
- * @param[in] field         – wskaźnik na pole,
+ * Funkcja wpisuje do tablicy podanej jako parametr @p adjoining identyfikatory
+ * pól z którymi sąsiaduje pole @p field. Jeżeli @p field ma mniej niż czterech
+ * sąsiadów, reszta tablicy uzupełniana jest wartościami @ref FIELD_NONE.
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola,
  * @param[out] adjoining    – tablica, do której zostaną zapisani sąsiedzi pola
  *                            @p field.
+ * @return Liczba pól z którymi styka się pole @p field.
+ */
+uint32_t field_adjoining(const board_t *b, field_t field,
+                         field_t adjoining[ADJOINING_FIELDS]);
+
+
+/** @brief Przygotowanie planszy do zmiany właściciela pola.
+ * Funkcja rezerwuje pamięć potrzebną funkcjom @ref field_take
+ * i @ref field_release wywołanym dla pola @p field, tak aby one same nie
+ * mogły się nie powieść.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola, które zmieni właściciela.
+ * @return Wartość @p true jeżeli udało się zarezerwować pamięć, @p false
+ * w przeciwnym wypadku.
  */
-void field_adjoining(field_t *field, field_t *adjoining[ADJOINING_FIELDS]);
+bool field_reserve(board_t *b, field_t field);
 
 
-/** @brief Ilość pól sąsiadujących.
- * @param[in] field         – wskaźnik na pole.
- * @return Funkcja zwraca liczbę pól z którymi styka się pole @p field.
+/** @brief Zajęcie wolnego pola przez gracza.
+ * Pole staje się własnością gracza i zostaje złączone z sąsiednimi obszarami
+ * tego gracza. Przed wywołaniem należy wywołać @ref field_reserve.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator wolnego pola,
+ * @param[in] player_id     – identyfikator gracza.
  */
-uint32_t field_adjoining_size(const field_t *field);
+void field_take(board_t *b, field_t field, uint32_t player_id);
 
 
-/** @brief Tworzy i inicjuje tablicę pól.
- * Funkcja tworzy i inicjuje dwuwymiarową tablicę pól reprezentującą planszę
- * gry Gamma o wielkości `widthd * height`.
- * @param[in] width         – ilość kolumn,
- * @param[in] height        – ilość wierszy.
- * @return Wskaźnik do utworzonej tablicy lub `NULL` jeżeli alokacja się
- * nie powiodła.
+/** @brief Przygotowanie planszy do zajęcia wielu pól funkcją @ref field_claim.
+ * Zajmowanie pól tą funkcją możliwe jest jedynie na planszy w trybie gęstym
+ * (@ref BOARD_STORAGE_DENSE) z wyłączonym dziennikiem zmian.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] count         – liczba pól, które zostaną zajęte.
+ * @return Wartość @p true jeżeli można zająć pola, @p false jeżeli plansza
+ * jest w innym trybie, zapisuje zmiany lub zabrakło pamięci.
  */
-field_t *field_board_new(uint32_t width, uint32_t height);
+bool field_reserve_claims(board_t *b, uint64_t count);
 
 
-/** @brief Odczytuje pole z tablicy pól.
- * @param[in] b             – wskaźnik na tablicę pól,
- * @param[in] field_id      – numer pozycji do odczytania.
- * @return Wskaźnik na pole na pozycji @p field_id w tablicy @p b.
+/** @brief Zajęcie wolnego pola przylegającego do jednego obszaru gracza.
+ * Pole dołączane jest do jedynego sąsiedniego obszaru gracza. Funkcja czyta
+ * jedynie sąsiadów pola i zapisuje samo pole, więc może być wywoływana
+ * równolegle dla pól, które nie sąsiadują ze sobą ani ze wspólnym polem.
+ * Liczniki obszaru i planszy uzupełnia następnie @ref field_claim_finish.
+ * Przed wywołaniem należy wywołać @ref field_reserve_claims.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator wolnego pola,
+ * @param[in] player_id     – identyfikator gracza.
+ * @return Identyfikator obszaru, do którego dołączono pole.
  */
-field_t *field_at_board(field_t *b, uint64_t field_id);
+uint32_t field_claim(board_t *b, field_t field, uint32_t player_id);
 
 
-/** @brief Złączenie dwóch obszarów w jeden.
- * Funkcja złącza dwa obszary do których należą @p field1 i @p field2.
- * @param[in, out] field1   – wskaźnik na pierwsze pole,
- * @param[in, out] field2   – wskaźnik na drugie pole.
+/** @brief Uzupełnienie liczników planszy po zajęciu pola funkcją
+ * @ref field_claim.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] area          – identyfikator obszaru zwrócony przez
+ *                            @ref field_claim.
  */
-void field_connect_area(field_t *field1, field_t *field2);
+void field_claim_finish(board_t *b, uint32_t area);
 
 
-/** @brief Rozbicie obszaru na pojedyńcze pola.
- * W wyniku działania funkcji obszar do którego należy pole @p field zostaje
- * rozbity na obszary składające się z pojedyńczych pól.
- * @param[in, out] field    – wskaźnik na pole.
+/** @brief Zwolnienie zajętego pola.
+ * Pole staje się wolne, a obszar do którego należało zostaje podzielony
+ * na spójne części. Przed wywołaniem należy wywołać @ref field_reserve.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator zajętego pola.
  */
-void field_split_area(field_t *field);
+void field_release(board_t *b, field_t field);
 
 
 /** @brief Zliczenie sąsiednich obszarów należących do danego gracza.
  * Funkcja zlicza przylegające do danego pola obszary, które są własnością
  * danego gracza.
- * @param[in] field         – wskaźnik na pole,
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola,
  * @param[in] player_id     – identyfikator gracza.
  * @return Liczba obszarów przylegających do pola `field` należących do gracza
- * o identyfikatorze @p player_id, lub `0` gdy któryś parametr jest niepoprawny.
+ * o identyfikatorze @p player_id.
  */
-uint32_t field_count_adjoining_areas(const field_t *field, uint32_t player_id);
+uint32_t field_count_adjoining_areas(const board_t *b, field_t field,
+                                     uint32_t player_id);
 
 
 /** @brief Zliczenie sąsiednich pól należących do danego gracza.
  * Funkcja zlicza pola przylegające do danego pola, które są własnością danego
  * gracza.
- * @param[in] field         – wskaźnik pola,
+ * @param[in] b             – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola,
  * @param[in] player_id     – identyfikator gracza.
  * @return Liczba pól przylegających do pola `field` należących do gracza
  * o identyfikatorze @p player_id, lub `0` gdy któryś parametr jest niepoprawny.
  */
-uint32_t field_count_adjoining_fields(const field_t *field, uint32_t player_id);
+uint32_t field_count_adjoining_fields(const board_t *b, field_t field,
+                                      uint32_t player_id);
 
 
 /** @brief Zliczenie obszarów, które powstaną po rozbiciu obszaru.
  * Funkcja podaje ile nowych obszarów powstanie po ściągnięciu pionka
  * zajmującego dane pole planszy.
- * @param[in, out] field    – wskaźnik pola.
+ * @param[in, out] b        – wskaźnik na planszę,
+ * @param[in] field         – identyfikator pola.
  * @return Liczba powstałych obszarów przylegających do pola @p field należących
  * do gracza, którego pionek znajduje się na tym polu.
  */
-uint32_t field_count_adjoining_areas_after_breaking(field_t *field);
+uint32_t field_count_adjoining_areas_after_breaking(board_t *b, field_t field);
 
 
-/** @brief Łączy sąsiadujące pola danego gracza w obszary.
- * Procedura konstruuje obszary tworzone przez pola gracza o identyfikatorze
- * @p player_id sąsiadujące z polem @p field.
- * @param[in, out] field    – wskaźnik pola,
- * @param[in] player_id     – identyfikator gracza.
+/** @brief Rozpoczyna zapisywanie zmian planszy w dzienniku.
+ * Od tej chwili przed każdym zapisem pola lub obszaru w trakcie zmiany
+ * rozpoczętej funkcją @ref field_journal_begin zapamiętywany jest jego
+ * poprzedni stan. Dotychczasowe zapisy dziennika są usuwane.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true, lub @p false gdy @p b jest `NULL`-em.
+ */
+bool field_journal_start(board_t *b);
+
+
+/** @brief Kończy zapisywanie zmian planszy i zwalnia dziennik.
+ * @param[in, out] b        – wskaźnik na planszę.
+ */
+void field_journal_stop(board_t *b);
+
+
+/** @brief Rozpoczyna w dzienniku nową zmianę planszy.
+ * Kolejne zapisy pól i obszarów (np. przez @ref field_take
+ * i @ref field_release) należą do tej zmiany. Jeżeli w trakcie zmiany
+ * zabraknie pamięci na dziennik, zostaje on wyczyszczony, co widać
+ * po wyniku @ref field_journal_changes.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli zmiana jest zapisywana, @p false jeżeli
+ * dziennik jest wyłączony lub zabrakło pamięci (dziennik zostaje wtedy
+ * wyczyszczony).
+ */
+bool field_journal_begin(board_t *b);
+
+
+/** @brief Liczba zmian planszy zapisanych w dzienniku.
+ * @param[in] b             – wskaźnik na planszę.
+ * @return Liczba zmian, które można cofnąć.
+ */
+uint64_t field_journal_changes(const board_t *b);
+
+
+/** @brief Cofa ostatnią zapisaną zmianę planszy.
+ * Odtwarza właścicieli i obszary pól, opisy obszarów i liczniki planszy
+ * sprzed zmiany w czasie proporcjonalnym do liczby zapisów w zmianie.
+ * @param[in, out] b        – wskaźnik na planszę.
+ * @return Wartość @p true jeżeli cofnięto zmianę, @p false jeżeli dziennik
+ * jest pusty lub zabrakło pamięci na skopiowanie współdzielonych fragmentów
+ * planszy (plansza pozostaje wtedy bez zmian).
  */
-void field_rebuild_areas_around(field_t *field, uint32_t player_id);
+bool field_journal_undo(board_t *b);
 
 
 #endif /* FIELD_H */
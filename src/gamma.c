@@ -5,38 +5,330 @@
  * @date 12.06.2020
  */
 
+/** Makro udostępniające flagi `MAP_ANONYMOUS` i `MAP_NORESERVE`.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "gamma.h"
 #include "field.h"
 #include "stringology.h"
 #include "isnull.h"
 
 
+/** Rozmiar bloku pamięci, od którego jest on mapowany bezpośrednio
+ * z wyzerowanych stron systemu operacyjnego. */
+#define MAP_THRESHOLD ((size_t) 1 << 16)
+
+
+/** Rozmiar dużej strony pamięci. */
+#define HUGE_PAGE_SIZE ((size_t) 1 << 21)
+
+
+/** Liczba pól wiersza wypisywanych naraz przez @ref gamma_board_buffer. */
+#define BOARD_CHUNK 1024
+
+
+/** Liczba pól odczytywanych naraz przez @ref gamma_gather. */
+#define GATHER_CHUNK 256
+
+
+/** Liczba bitów w słowie bitmapy zajętych pól. */
+#define WORD_BITS 64
+
+
+/** Liczba pól planszy, od której jest ona przeglądana przez wiele wątków. */
+#define PARALLEL_FIELDS ((uint64_t) 1 << 20)
+
+
+/** Największa liczba wątków przeglądających planszę. */
+#define MAX_THREADS 128
+
+
+/** Największa liczba ruchów wykonywanych naraz równolegle przez
+ * @ref gamma_move_bulk. */
+#define BULK_WINDOW 4096
+
+
+/** Najmniejsza liczba ruchów, które @ref gamma_move_bulk wykonuje
+ * równolegle; gdy jest ich mniej, ruchy wykonywane są kolejno. */
+#define BULK_MIN 256
+
+
+/** Rozmiar tablicy mieszającej pól ruchów wykonywanych równolegle przez
+ * @ref gamma_move_bulk (potęga dwójki, dwa razy większa od
+ * @ref BULK_WINDOW). */
+#define BULK_SET 8192
+
+
+/** Sygnatura migawki gry (napis `GAMMASN1`). */
+#define SNAPSHOT_MAGIC UINT64_C(0x314e53414d4d4147)
+
+
+/** Wersja formatu migawki gry. */
+#define SNAPSHOT_VERSION 1
+
+
+/** Znacznik odcinka wiersza migawki złożonego z samych wolnych pól. */
+#define SNAPSHOT_FREE 0
+
+
+/** Znacznik odcinka wiersza migawki zapisanego pole po polu. */
+#define SNAPSHOT_RAW 1
+
+
+/** Odwrotność części pól planszy, po których zmianie opis planszy tworzony
+ * jest od nowa zamiast poprawiania kolejnych pól. */
+#define DIRTY_RATIO 8
+
+
+/** Największa liczba graczy, których liczniki zmienia jeden ruch: gracz
+ * wykonujący ruch i właściciele pola, jego sąsiadów i sąsiadów sąsiadów
+ * (13 pól). */
+#define JOURNAL_PLAYERS 14
+
+
 /** Struktura reprezentująca informacje na temat gracza gry Gamma.
+ * Wyzerowana struktura opisuje gracza na początku gry.
  */
 typedef struct player {
-    uint32_t id; /**< Identyfikator gracza. */
     bool golden_move_done; /**< Informacja o tym czy wykonano już złoty ruch. */
     uint64_t occupied_fields; /**< Liczba pól zajętych przez gracza. */
     uint64_t free_adjoining; /**< Liczba wolnych pól przylegających do pól gracza. */
     uint32_t areas; /**< Liczba obszarów gracza na planszy. */
+    uint64_t enemy_adjoining; /**< Liczba pól innych graczy przylegających
+                               * do pól gracza. */
+    field_t *candidates; /**< Pola innych graczy, które przylegały do pól
+                          * gracza – kandydaci na złoty ruch. Lista może
+                          * zawierać nieaktualne pola i powtórzenia. */
+    uint64_t candidates_size; /**< Liczba elementów listy kandydatów. */
+    uint64_t candidates_capacity; /**< Rozmiar tablicy kandydatów. */
+    bool candidates_lost; /**< Informacja o tym czy lista kandydatów jest
+                           * niekompletna (nie udało się jej powiększyć). */
+    bool candidates_listed; /**< Informacja o tym czy gracz jest na liście
+                             * graczy z przydzieloną tablicą kandydatów. */
+    uint32_t candidates_next; /**< Następny gracz na liście graczy
+                               * z przydzieloną tablicą kandydatów lub `0`. */
 } player_t ;
 
 
+/** Liczniki gracza zapisane w dzienniku ruchów.
+ */
+typedef struct gamma_counters {
+    uint32_t player; /**< Identyfikator gracza. */
+    bool golden_move_done; /**< Informacja o tym czy wykonano już złoty ruch. */
+    uint32_t areas; /**< Liczba obszarów gracza na planszy. */
+    uint64_t occupied_fields; /**< Liczba pól zajętych przez gracza. */
+    uint64_t free_adjoining; /**< Liczba wolnych pól przylegających do pól
+                              * gracza. */
+    uint64_t enemy_adjoining; /**< Liczba pól innych graczy przylegających
+                               * do pól gracza. */
+} gamma_counters_t;
+
+
+/** Ruch zapisany w dzienniku ruchów.
+ * Zmiany planszy zapisywane są w dzienniku planszy, a tu – ruch i liczniki
+ * graczy sprzed ruchu.
+ */
+typedef struct gamma_change {
+    field_t field; /**< Identyfikator pola ruchu. */
+    uint32_t player; /**< Identyfikator gracza wykonującego ruch. */
+    bool golden; /**< Informacja o tym czy był to złoty ruch. */
+    uint32_t counters_size; /**< Liczba zapisanych liczników graczy. */
+    uint64_t counters; /**< Numer pierwszego z zapisanych liczników graczy
+                        * w tablicy gamma::counters. */
+} gamma_change_t;
+
+
+/** Lista wolnych pól przylegających do pól gracza, czyli jego legalnych
+ * zwykłych ruchów po osiągnięciu limitu obszarów. Lista może zawierać
+ * nieaktualne pola i powtórzenia; zawiera wszystkie aktualne pola.
+ */
+typedef struct gamma_frontier {
+    field_t *fields; /**< Pola listy. */
+    uint64_t size; /**< Liczba elementów listy. */
+    uint64_t capacity; /**< Rozmiar tablicy pól. */
+    bool built; /**< Informacja o tym czy lista została utworzona i jest
+                 * utrzymywana (nie zabrakło pamięci na jej powiększenie). */
+} gamma_frontier_t;
+
+
+/** Pas wierszy planszy przeglądany przez jeden wątek w poszukiwaniu
+ * kandydatów na złoty ruch gracza, czyli pól innych graczy przylegających
+ * do jego pól.
+ */
+typedef struct gamma_band {
+    const gamma_t *g; /**< Przeglądana gra. */
+    uint32_t id; /**< Identyfikator gracza. */
+    uint32_t first_row; /**< Pierwszy wiersz pasa. */
+    uint32_t last_row; /**< Wiersz za ostatnim wierszem pasa. */
+    bool stop_on_hit; /**< Informacja o tym czy przeglądanie kończy się
+                       * po znalezieniu pola, na którym na pewno można
+                       * wykonać złoty ruch. */
+    atomic_bool *stop; /**< Wspólna dla wątków flaga zakończenia. */
+    field_t *fields; /**< Znalezieni kandydaci. */
+    uint64_t size; /**< Liczba znalezionych kandydatów. */
+    uint64_t capacity; /**< Rozmiar tablicy kandydatów. */
+    bool hit; /**< Informacja o tym czy znaleziono pole, na którym na pewno
+               * można wykonać złoty ruch. */
+    bool failed; /**< Informacja o tym czy zabrakło pamięci. */
+} gamma_band_t;
+
+
+/** Wynik ruchu wykonywanego równolegle przez @ref gamma_move_bulk.
+ */
+typedef enum gamma_claim_state {
+    CLAIM_PENDING, /**< Ruch zostanie wykonany równolegle. */
+    CLAIM_FAILED, /**< Ruch jest nielegalny. */
+    CLAIM_DEFERRED, /**< Ruch zostanie wykonany kolejno, po ruchach
+                     * wykonanych równolegle. */
+    CLAIM_TAKEN /**< Pole zostało zajęte, należy uzupełnić liczniki. */
+} gamma_claim_state_t;
+
+
+/** Ruch wykonany równolegle przez @ref gamma_move_bulk wraz ze stanem
+ * sąsiedztwa pola sprzed ruchu, potrzebnym do uzupełnienia liczników
+ * graczy.
+ */
+typedef struct gamma_claim {
+    gamma_claim_state_t state; /**< Wynik ruchu. */
+    uint32_t area; /**< Obszar, do którego dołączono pole. */
+    uint32_t owners[ADJOINING_FIELDS]; /**< Właściciele sąsiednich pól. */
+    uint32_t fresh; /**< Liczba wolnych sąsiednich pól, które wcześniej
+                     * nie przylegały do pól gracza. */
+    uint32_t contact; /**< Bitmapa sąsiednich pól innych graczy, które
+                       * wcześniej nie przylegały do pól gracza. */
+} gamma_claim_t;
+
+
+/** Pas wierszy planszy, na którym jeden wątek wykonuje ruchy
+ * @ref gamma_move_bulk.
+ */
+typedef struct gamma_claim_band {
+    gamma_t *g; /**< Gra. */
+    const gamma_play_t *moves; /**< Ruchy. */
+    gamma_claim_t *claims; /**< Wyniki ruchów. */
+    size_t count; /**< Liczba ruchów. */
+    uint32_t first_row; /**< Pierwszy wiersz pasa. */
+    uint32_t last_row; /**< Wiersz za ostatnim wierszem pasa. */
+} gamma_claim_band_t;
+
+
+/** Pula nieużywanych silników gry.
+ */
+struct gamma_pool {
+    gamma_t **games; /**< Przechowywane, wyczyszczone silniki. */
+    size_t size; /**< Liczba przechowywanych silników. */
+    size_t capacity; /**< Największa liczba przechowywanych silników. */
+};
+
+
+/** Stan gry zapisywany w pliku planszy, gdy gra jest przechowywana w pliku.
+ * Listy kandydatów graczy nie są zapisywane – po otwarciu pliku są tworzone
+ * od nowa.
+ */
+typedef struct gamma_file {
+    uint32_t height; /**< Wysokość planszy. */
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t no_players; /**< Liczba graczy w rozgrywce. */
+    uint32_t areas_limit; /**< Limit obszarów. */
+    uint64_t ocupied_fields; /**< Liczba zajętych pól na planszy. */
+    player_t players[]; /**< Tablica graczy. */
+} gamma_file_t;
+
+
 /** Struktura reprezentująca instancję gry Gamma, przechowująca związane z nią
  * informacje.
  */
 struct gamma {
     uint32_t height; /**< Wysokość planszy. */
     uint32_t width; /**< Szerokość planszy. */
-    field_t *fields; /**< Dwuwymiarowa tablica pól. */
+    board_t *board; /**< Plansza gry. */
     uint32_t no_players; /**< Liczba graczy w rozgrywce. */
     uint32_t areas_limit; /**< Limit obszarów. */
     player_t *players; /**< Tablica graczy. */
     uint64_t ocupied_fields; /**< Liczba zajętych pól na planszy. */
+    gamma_file_t *file; /**< Stan gry w pliku planszy lub `NULL`, jeżeli gra
+                         * nie jest przechowywana w pliku. */
+    bool read_only; /**< Informacja o tym czy gra została otwarta tylko
+                     * do odczytu i nie można wykonywać w niej ruchów. */
+    uint32_t candidates_head; /**< Pierwszy gracz na liście graczy
+                               * z przydzieloną tablicą kandydatów lub `0`. */
+    gamma_allocator_t allocator; /**< Funkcje przydzielające pamięć. */
+    void *memory; /**< Blok pamięci zawierający strukturę gry. */
+    size_t memory_size; /**< Rozmiar bloku pamięci. */
+    uint64_t version; /**< Liczba zmian właścicieli pól. */
+    bool rendered; /**< Informacja o tym czy plansza była już opisana
+                    * i od tego czasu zapamiętywane są zmienione pola. */
+    bool dirty_lost; /**< Informacja o tym czy lista zmienionych pól jest
+                      * niekompletna. */
+    field_t *dirty; /**< Pola zmienione od ostatniego opisu planszy. */
+    uint64_t dirty_size; /**< Liczba pól na liście zmienionych pól. */
+    uint64_t dirty_capacity; /**< Rozmiar tablicy zmienionych pól. */
+    bool journal; /**< Informacja o tym czy ruchy zapisywane są w dzienniku,
+                   * tak aby można je było cofnąć. */
+    gamma_change_t *changes; /**< Zapisane ruchy: wykonane, a za nimi
+                              * cofnięte, które można powtórzyć. */
+    uint64_t changes_size; /**< Liczba zapisanych wykonanych ruchów. */
+    uint64_t changes_count; /**< Liczba zapisanych ruchów wraz
+                             * z cofniętymi. */
+    uint64_t changes_capacity; /**< Rozmiar tablicy ruchów. */
+    gamma_counters_t *counters; /**< Liczniki graczy zapisanych ruchów. */
+    uint64_t counters_capacity; /**< Rozmiar tablicy liczników. */
+    uint64_t *taken_map; /**< Bitmapa zajętych pól lub `NULL`, jeżeli jej
+                          * nie utworzono. Wiersz zajmuje @ref row_words
+                          * słów, a bity za końcem wiersza są ustawione. */
+    uint64_t *full_map; /**< Bitmapa słów @ref taken_map bez wolnych pól. */
+    uint64_t row_words; /**< Liczba słów wiersza @ref taken_map. */
+    gamma_frontier_t *frontiers; /**< Listy wolnych pól przylegających
+                                  * do pól graczy lub `NULL`, jeżeli żadnej
+                                  * nie utworzono. */
+    uint32_t threads; /**< Liczba wątków przeglądających planszę lub `0`
+                       * dla liczby dostępnych procesorów. */
+    _Atomic uint64_t sequence; /**< Licznik sekwencji dla czytelników z innych
+                                * wątków, nieparzysty w trakcie zmiany stanu
+                                * gry. */
 };
 
 
+/** Nagłówek migawki gry.
+ * Za nagłówkiem znajdują się kolejne wiersze planszy (od dolnego),
+ * podzielone na odcinki po @ref BOARD_CHUNK pól, a po nich opisy graczy
+ * (@ref gamma_snapshot_player). Odcinek zaczyna się znacznikiem
+ * @ref SNAPSHOT_FREE lub @ref SNAPSHOT_RAW, po którym następują
+ * identyfikatory właścicieli pól o rozmiarze @ref owner_size bajtów.
+ */
+typedef struct gamma_snapshot {
+    uint64_t magic; /**< Sygnatura @ref SNAPSHOT_MAGIC. */
+    uint32_t version; /**< Wersja formatu @ref SNAPSHOT_VERSION. */
+    uint32_t owner_size; /**< Rozmiar identyfikatora właściciela pola. */
+    uint32_t height; /**< Wysokość planszy. */
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t no_players; /**< Liczba graczy w rozgrywce. */
+    uint32_t areas_limit; /**< Limit obszarów. */
+    uint64_t ocupied_fields; /**< Liczba zajętych pól na planszy. */
+} gamma_snapshot_t;
+
+
+/** Liczniki gracza zapisywane w migawce gry.
+ */
+typedef struct gamma_snapshot_player {
+    uint64_t occupied_fields; /**< Liczba pól zajętych przez gracza. */
+    uint64_t free_adjoining; /**< Liczba wolnych pól przylegających do pól
+                              * gracza. */
+    uint64_t enemy_adjoining; /**< Liczba pól innych graczy przylegających
+                               * do pól gracza. */
+    uint32_t areas; /**< Liczba obszarów gracza na planszy. */
+    uint32_t golden_move_done; /**< Niezerowa, jeżeli wykonano złoty ruch. */
+} gamma_snapshot_player_t;
+
+
 /** @brief Sprawdzenie poprawności identyfikatora gracza.
  * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player        – identyfikator gracza.
@@ -65,13 +357,11 @@ static bool test_field(const gamma_t *g, uint32_t x, uint32_t y) {
  * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] x             – numer kolumny,
  * @param[in] y             – numer wiersza.
- * @return Wskaźnik do struktury przechowującej informacje dotyczące pola
- * o współrzędnych (@p x, @p y). Jeżeli któryś z argumentów jest
- * niepoprawny wynikiem funkcji jest `NULL`.
+ * @return Identyfikator pola o współrzędnych (@p x, @p y). Jeżeli któryś
+ * z argumentów jest niepoprawny wynikiem funkcji jest @ref FIELD_NONE.
  */
-static field_t *gamma_get_field(gamma_t *g, uint32_t x, uint32_t y) {
-    return !test_field(g, x, y) ? NULL :
-                    field_at_board(g->fields, (uint64_t) (g->width) * y + x);
+static field_t gamma_get_field(const gamma_t *g, uint32_t x, uint32_t y) {
+    return !test_field(g, x, y) ? FIELD_NONE : field_at(x, y);
 }
 
 
@@ -86,48 +376,481 @@ static player_t *gamma_get_player(const gamma_t *g, uint32_t player) {
 }
 
 
+/** @brief Identyfikator gracza.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player        – wskaźnik do informacji o graczu.
+ * @return Identyfikator gracza, czyli jego numer w tablicy graczy liczony
+ * od jedynki.
+ */
+static uint32_t gamma_player_id(const gamma_t *g, const player_t *player) {
+    return (uint32_t) (player - g->players) + 1;
+}
+
+
+/** @brief Gracze, dla których pole jest kandydatem na złoty ruch.
+ * Pole zajęte przez gracza jest kandydatem na złoty ruch dla każdego innego
+ * gracza, którego pionek stoi na sąsiednim polu.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola,
+ * @param[out] players      – tablica do której zostaną zapisani gracze.
+ * @return Liczba różnych graczy zapisanych do tablicy @p players.
+ */
+static uint32_t gamma_contact_players(const gamma_t *g, field_t field,
+                                      uint32_t players[ADJOINING_FIELDS]) {
+    uint32_t owner = field_owner(g->board, field);
+    if (owner == 0) {
+        return 0;
+    }
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t current = field_owner(g->board, adjoining[i]);
+        bool add = current != 0 && current != owner;
+        for (uint32_t j = 0; j < result && add; ++j) {
+            add = players[j] != current;
+        }
+        if (add) {
+            players[result++] = current;
+        }
+    }
+    return result;
+}
+
+
+/** @brief Dopisanie pola do listy kandydatów na złoty ruch gracza.
+ * Jeżeli nie uda się powiększyć listy, zostaje ona oznaczona jako
+ * niekompletna i @ref gamma_golden_possible przegląda całą planszę.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] player   – wskaźnik do informacji związanych z graczem,
+ * @param[in] field         – identyfikator pola.
+ */
+static void gamma_candidate_push(gamma_t *g, player_t *player, field_t field) {
+    if (player->candidates_lost) {
+        return;
+    }
+    if (player->candidates_size == player->candidates_capacity) {
+        uint64_t capacity = player->candidates_capacity == 0 ?
+                            ADJOINING_FIELDS : player->candidates_capacity * 2;
+        field_t *candidates = realloc(player->candidates,
+                                      capacity * sizeof(field_t));
+        if (ISNULL(candidates)) {
+            free(player->candidates);
+            player->candidates = NULL;
+            player->candidates_size = 0;
+            player->candidates_capacity = 0;
+            player->candidates_lost = true;
+            return;
+        }
+        player->candidates = candidates;
+        player->candidates_capacity = capacity;
+        if (!player->candidates_listed) {
+            /* Dzięki liście usunięcie gry nie przegląda wszystkich graczy. */
+            player->candidates_listed = true;
+            player->candidates_next = g->candidates_head;
+            g->candidates_head = gamma_player_id(g, player);
+        }
+    }
+    player->candidates[player->candidates_size++] = field;
+}
+
+
+/** @brief Zapamiętanie zmiany właściciela pola.
+ * Pola zapamiętywane są jedynie po opisaniu planszy. Gdy zmienionych pól jest
+ * zbyt wiele lub nie uda się powiększyć listy, zostaje ona oznaczona jako
+ * niekompletna i @ref gamma_board_update opisuje całą planszę.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola.
+ */
+static void gamma_dirty_push(gamma_t *g, field_t field) {
+    if (!g->rendered || g->dirty_lost) {
+        return;
+    }
+    if (g->dirty_size == g->dirty_capacity) {
+        uint64_t capacity = g->dirty_capacity == 0 ?
+                            ADJOINING_FIELDS : g->dirty_capacity * 2;
+        field_t *dirty = NULL;
+        if (capacity <= (uint64_t) g->width * g->height / DIRTY_RATIO) {
+            dirty = realloc(g->dirty, capacity * sizeof(field_t));
+        }
+        if (ISNULL(dirty)) {
+            free(g->dirty);
+            g->dirty = NULL;
+            g->dirty_size = 0;
+            g->dirty_capacity = 0;
+            g->dirty_lost = true;
+            return;
+        }
+        g->dirty = dirty;
+        g->dirty_capacity = capacity;
+    }
+    g->dirty[g->dirty_size++] = field;
+}
+
+
+/** @brief Aktualizacja kandydatów na złoty ruch wokół pola.
+ * Zmiana właściciela pola wpływa jedynie na to pole i jego sąsiadów.
+ * Procedurę należy wywołać z @p added równym @p false przed zmianą
+ * właściciela pola oraz z @p added równym @p true po zmianie.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola, którego właściciel się
+ *                            zmienia,
+ * @param[in] added         – informacja o tym czy zliczać pola (po zmianie)
+ *                            czy je odliczać (przed zmianą).
+ */
+static void gamma_update_candidates(gamma_t *g, field_t field, bool added) {
+    field_t around[ADJOINING_FIELDS + 1];
+    uint32_t size = field_adjoining(g->board, field, around);
+    around[size++] = field;
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t players[ADJOINING_FIELDS];
+        uint32_t count = gamma_contact_players(g, around[i], players);
+        for (uint32_t j = 0; j < count; ++j) {
+            player_t *player = &g->players[players[j] - 1];
+            if (added) {
+                player->enemy_adjoining++;
+                gamma_candidate_push(g, player, around[i]);
+            } else {
+                player->enemy_adjoining--;
+            }
+        }
+    }
+}
+
+
+/** @brief Dopisanie gracza do zbioru graczy.
+ * @param[in, out] players  – tablica różnych graczy,
+ * @param[in] count         – liczba graczy w tablicy,
+ * @param[in] player        – identyfikator gracza lub `0`.
+ * @return Liczba graczy w tablicy po dopisaniu.
+ */
+static uint32_t gamma_players_add(uint32_t players[JOURNAL_PLAYERS],
+                                  uint32_t count, uint32_t player) {
+    if (player == 0) {
+        return count;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (players[i] == player) {
+            return count;
+        }
+    }
+    players[count] = player;
+    return count + 1;
+}
+
+
+/** @brief Gracze, których liczniki może zmienić ruch na polu.
+ * Ruch zmienia liczniki gracza wykonującego ruch, a przez zmianę kandydatów
+ * na złoty ruch (@ref gamma_update_candidates) – również właścicieli pól
+ * odległych od pola ruchu o co najwyżej dwa.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola ruchu,
+ * @param[in] player        – identyfikator gracza wykonującego ruch,
+ * @param[out] players      – tablica do której zostaną zapisani gracze.
+ * @return Liczba różnych graczy zapisanych do tablicy @p players.
+ */
+static uint32_t gamma_journal_players(const gamma_t *g, field_t field,
+                                      uint32_t player,
+                                      uint32_t players[JOURNAL_PLAYERS]) {
+    uint32_t count = gamma_players_add(players, 0, player);
+    count = gamma_players_add(players, count, field_owner(g->board, field));
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        count = gamma_players_add(players, count,
+                                  field_owner(g->board, adjoining[i]));
+        field_t next[ADJOINING_FIELDS];
+        uint32_t next_size = field_adjoining(g->board, adjoining[i], next);
+        for (uint32_t j = 0; j < next_size; ++j) {
+            count = gamma_players_add(players, count,
+                                      field_owner(g->board, next[j]));
+        }
+    }
+    return count;
+}
+
+
+/** @brief Zapewnienie miejsca w dzienniku ruchów na kolejny ruch.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] index         – numer ruchu,
+ * @param[in] first         – numer pierwszego licznika ruchu.
+ * @return Wartość @p true jeżeli udało się przydzielić pamięć, @p false
+ * w przeciwnym wypadku.
+ */
+static bool gamma_journal_reserve(gamma_t *g, uint64_t index, uint64_t first) {
+    if (index == g->changes_capacity) {
+        uint64_t capacity = index == 0 ? ADJOINING_FIELDS : index * 2;
+        gamma_change_t *changes = realloc(g->changes,
+                                          capacity * sizeof(gamma_change_t));
+        if (ISNULL(changes)) {
+            return false;
+        }
+        g->changes = changes;
+        g->changes_capacity = capacity;
+    }
+    if (first + JOURNAL_PLAYERS > g->counters_capacity) {
+        uint64_t capacity = g->counters_capacity == 0 ?
+                            2 * JOURNAL_PLAYERS : g->counters_capacity * 2;
+        gamma_counters_t *counters = realloc(g->counters,
+                                             capacity
+                                             * sizeof(gamma_counters_t));
+        if (ISNULL(counters)) {
+            return false;
+        }
+        g->counters = counters;
+        g->counters_capacity = capacity;
+    }
+    return true;
+}
+
+
+/** @brief Zapisanie ruchu w dzienniku ruchów.
+ * Procedurę należy wywołać przed zmianą planszy i liczników graczy. Ruch
+ * różny od pierwszego z cofniętych usuwa z dziennika cofnięte ruchy,
+ * a taki sam – powtarza go. Gdy zabraknie pamięci, dziennik zostaje
+ * wyczyszczony.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player        – wskaźnik do informacji o graczu wykonującym
+ *                            ruch,
+ * @param[in] field         – identyfikator pola ruchu,
+ * @param[in] golden        – informacja o tym czy jest to złoty ruch.
+ */
+static void gamma_journal_begin(gamma_t *g, const player_t *player,
+                                field_t field, bool golden) {
+    if (!g->journal) {
+        return;
+    }
+    if (field_journal_changes(g->board) != g->changes_size) {
+        /* Zabrakło pamięci na dziennik planszy. */
+        g->changes_size = 0;
+        g->changes_count = 0;
+    }
+    uint64_t index = g->changes_size;
+    uint64_t first = index == 0 ? 0 : g->changes[index - 1].counters
+                                      + g->changes[index - 1].counters_size;
+    if (!gamma_journal_reserve(g, index, first)
+            || !field_journal_begin(g->board)) {
+        g->changes_size = 0;
+        g->changes_count = 0;
+        field_journal_start(g->board);
+        return;
+    }
+    uint32_t id = gamma_player_id(g, player);
+    gamma_change_t *change = &g->changes[index];
+    if (index >= g->changes_count || change->field != field
+            || change->player != id || change->golden != golden) {
+        g->changes_count = index + 1;
+    }
+    uint32_t players[JOURNAL_PLAYERS];
+    uint32_t count = gamma_journal_players(g, field, id, players);
+    for (uint32_t i = 0; i < count; ++i) {
+        const player_t *current = &g->players[players[i] - 1];
+        g->counters[first + i] = (gamma_counters_t) {
+                .player = players[i],
+                .golden_move_done = current->golden_move_done,
+                .areas = current->areas,
+                .occupied_fields = current->occupied_fields,
+                .free_adjoining = current->free_adjoining,
+                .enemy_adjoining = current->enemy_adjoining };
+    }
+    *change = (gamma_change_t) { .field = field, .player = id,
+                                 .golden = golden, .counters_size = count,
+                                 .counters = first };
+    g->changes_size = index + 1;
+}
+
+
+/** @brief Porównanie identyfikatorów pól dla funkcji `qsort`.
+ * @param[in] a             – wskaźnik na pierwsze pole,
+ * @param[in] b             – wskaźnik na drugie pole.
+ * @return Liczba ujemna, zero lub dodatnia gdy pierwsze pole jest
+ * odpowiednio mniejsze, równe lub większe od drugiego.
+ */
+static int gamma_field_compare(const void *a, const void *b) {
+    field_t f1 = *(const field_t *) a, f2 = *(const field_t *) b;
+    return (f1 > f2) - (f1 < f2);
+}
+
+
+/** @brief Sprawdzenie czy pole należy do listy wolnych pól przy polach gracza.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza,
+ * @param[in] field         – identyfikator pola.
+ * @return Wartość @p true, jeżeli pole jest wolne i przylega do pola gracza.
+ */
+static bool gamma_frontier_valid(const gamma_t *g, uint32_t id, field_t field) {
+    return field_owner(g->board, field) == 0
+           && field_count_adjoining_fields(g->board, field, id) > 0;
+}
+
+
+/** @brief Usunięcie z listy wolnych pól przy polach gracza nieaktualnych pól.
+ * Powtórzenia usuwane są tylko wtedy, gdy lista zawiera więcej pól niż
+ * wolnych pól przylegających do pól gracza, więc po wywołaniu lista zawiera
+ * dokładnie te pola.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza.
+ */
+static void gamma_frontier_compact(gamma_t *g, uint32_t id) {
+    gamma_frontier_t *frontier = &g->frontiers[id - 1];
+    uint64_t valid = 0;
+    for (uint64_t i = 0; i < frontier->size; ++i) {
+        if (gamma_frontier_valid(g, id, frontier->fields[i])) {
+            frontier->fields[valid++] = frontier->fields[i];
+        }
+    }
+    frontier->size = valid;
+    if (frontier->size > g->players[id - 1].free_adjoining) {
+        qsort(frontier->fields, frontier->size, sizeof(field_t),
+              gamma_field_compare);
+        valid = 0;
+        for (uint64_t i = 0; i < frontier->size; ++i) {
+            if (valid == 0 || frontier->fields[valid - 1]
+                              != frontier->fields[i]) {
+                frontier->fields[valid++] = frontier->fields[i];
+            }
+        }
+        frontier->size = valid;
+    }
+}
+
+
+/** @brief Dopisanie pola do listy wolnych pól przy polach gracza.
+ * Pełna lista jest najpierw porządkowana. Jeżeli nie uda się jej
+ * powiększyć, lista jest usuwana i zostanie utworzona od nowa przy
+ * następnym zapytaniu.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza,
+ * @param[in] field         – identyfikator pola.
+ */
+static void gamma_frontier_push(gamma_t *g, uint32_t id, field_t field) {
+    gamma_frontier_t *frontier = &g->frontiers[id - 1];
+    if (!frontier->built) {
+        return;
+    }
+    if (frontier->size == frontier->capacity) {
+        gamma_frontier_compact(g, id);
+        /* Powiększamy tablicę, gdy porządkowanie zwolniło mniej niż jej
+         * połowę. */
+        if (frontier->capacity == 0
+                || frontier->size * 2 > frontier->capacity) {
+            uint64_t capacity = frontier->capacity == 0 ?
+                                ADJOINING_FIELDS : frontier->capacity * 2;
+            field_t *fields = realloc(frontier->fields,
+                                      capacity * sizeof(field_t));
+            if (ISNULL(fields)) {
+                free(frontier->fields);
+                *frontier = (gamma_frontier_t) { .built = false };
+                return;
+            }
+            frontier->fields = fields;
+            frontier->capacity = capacity;
+        }
+    }
+    frontier->fields[frontier->size++] = field;
+}
+
+
+/** @brief Zapisanie pola w bitmapie zajętych pól, jeżeli ją utworzono.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola,
+ * @param[in] taken         – informacja o tym czy pole jest zajęte.
+ */
+static void gamma_taken_update(gamma_t *g, field_t field, bool taken) {
+    if (ISNULL(g->taken_map)) {
+        return;
+    }
+    uint64_t word = field_row(field) * g->row_words
+                    + field_column(field) / WORD_BITS;
+    uint64_t bit = (uint64_t) 1 << (field_column(field) % WORD_BITS);
+    uint64_t full = (uint64_t) 1 << (word % WORD_BITS);
+    if (taken) {
+        g->taken_map[word] |= bit;
+    } else {
+        g->taken_map[word] &= ~bit;
+    }
+    if (g->taken_map[word] == UINT64_MAX) {
+        g->full_map[word / WORD_BITS] |= full;
+    } else {
+        g->full_map[word / WORD_BITS] &= ~full;
+    }
+}
+
+
+/** @brief Aktualizacja struktur legalnych ruchów po zmianie właściciela pola.
+ * Zajęte pole dopisywane jest do bitmapy zajętych pól, a jego wolni
+ * sąsiedzi – do listy jego właściciela. Zwolnione pole dopisywane jest
+ * do list właścicieli sąsiednich pól.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] field         – identyfikator pola, którego właściciel się
+ *                            zmienił.
+ */
+static void gamma_moves_update(gamma_t *g, field_t field) {
+    uint32_t owner = field_owner(g->board, field);
+    gamma_taken_update(g, field, owner != 0);
+    if (ISNULL(g->frontiers)) {
+        return;
+    }
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t current = field_owner(g->board, adjoining[i]);
+        if (owner != 0 && current == 0) {
+            gamma_frontier_push(g, owner, adjoining[i]);
+        } else if (owner == 0 && current != 0) {
+            gamma_frontier_push(g, current, field);
+        }
+    }
+}
+
+
 /** @brief Zajęcie pola przez gracza.
  * W wyniku działania funkcji wskazane pole zostaje zajęte przez gracza o
- * podanym identyfikatorze.
+ * podanym identyfikatorze. Wcześniej należy wywołać @ref field_reserve.
  * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
  * @param[in, out] player   – wskaźnik do informacji związanych z graczem
  *                            zajmującym pole,
- * @param[in, out] field    – wskaźnik do informacji związanych z zajmowanym
- *                            polem.
+ * @param[in] field         – identyfikator zajmowanego pola.
  */
-static void gamma_take_field(gamma_t *g, player_t *player, field_t *field) {
-    if (ISNULL(g) || ISNULL(player) || ISNULL(field) || field_owner(field) != 0) {
+static void gamma_take_field(gamma_t *g, player_t *player, field_t field) {
+    if (ISNULL(g) || ISNULL(player) || field == FIELD_NONE
+            || field_owner(g->board, field) != 0) {
         return;
     }
-    field_set_owner(field, player->id);
+    uint32_t id = gamma_player_id(g, player);
+    player->areas += 1 - field_count_adjoining_areas(g->board, field, id);
+    gamma_update_candidates(g, field, false);
+    field_take(g->board, field, id);
+    gamma_update_candidates(g, field, true);
+    gamma_dirty_push(g, field);
+    gamma_moves_update(g, field);
+    g->version++;
     g->ocupied_fields++;
     player->occupied_fields++;
-    player->areas += 1 - field_count_adjoining_areas(field, player->id);
-    field_t *adjoining[ADJOINING_FIELDS];
-    field_adjoining(field, adjoining);
-    for (uint32_t i = 0; i < field_adjoining_size(field); ++i) {
-        if (field_owner(adjoining[i]) != 0) {
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t owner = field_owner(g->board, adjoining[i]);
+        if (owner != 0) {
             uint32_t diff = 1;
-            for (uint32_t j = i + 1; j < field_adjoining_size(field); ++j) {
-                if (field_owner(adjoining[i]) == field_owner(adjoining[j])) {
+            for (uint32_t j = i + 1; j < size; ++j) {
+                if (owner == field_owner(g->board, adjoining[j])) {
                     diff = 0;
                     break;
                 }
             }
-            player_t *current = gamma_get_player(g, field_owner(adjoining[i]));
+            player_t *current = gamma_get_player(g, owner);
             if (ISNULL(current)) {
                 return;
             }
             current->free_adjoining -= diff;
         }
     }
-    uint32_t count_adj;
-    for (uint32_t i = 0; i < field_adjoining_size(field); ++i) {
-        count_adj = field_count_adjoining_fields(adjoining[i], player->id);
-        if (field_owner(adjoining[i]) == 0 && count_adj == 1) {
+    for (uint32_t i = 0; i < size; ++i) {
+        if (field_owner(g->board, adjoining[i]) == 0
+                && field_count_adjoining_fields(g->board, adjoining[i],
+                                                id) == 1) {
             player->free_adjoining++;
-        } else if (field_owner(adjoining[i]) == player->id) {
-            field_connect_area(adjoining[i], field);
         }
     }
 }
@@ -135,48 +858,53 @@ static void gamma_take_field(gamma_t *g, player_t *player, field_t *field) {
 
 /** @brief Zwolnienie pola zajętego przez gracza.
  * W wyniku funkcji zajęte przez pewnego gracza pole staje się wolne.
+ * Wcześniej należy wywołać @ref field_reserve.
  * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
- * @param[in, out] field    – wskaźnik do informacji związanych ze zwalnianym
- *                            polem.
+ * @param[in] field         – identyfikator zwalnianego pola.
  */
-static void gamma_release_field(gamma_t *g, field_t *field) {
-    if (ISNULL(g) || ISNULL(field)) {
+static void gamma_release_field(gamma_t *g, field_t field) {
+    if (ISNULL(g) || field == FIELD_NONE) {
         return;
     }
-    player_t *owner = gamma_get_player(g, field_owner(field));
+    player_t *owner = gamma_get_player(g, field_owner(g->board, field));
     if (ISNULL(owner)) {
         return;
     }
-    field_set_owner(field, 0);
-    field_split_area(field);
-    field_rebuild_areas_around(field, owner->id);
+    uint32_t owner_id = gamma_player_id(g, owner);
+    gamma_update_candidates(g, field, false);
+    field_release(g->board, field);
+    gamma_update_candidates(g, field, true);
+    gamma_dirty_push(g, field);
+    gamma_moves_update(g, field);
+    g->version++;
     uint32_t diff;
-    field_t *adjoining[ADJOINING_FIELDS];
-    field_adjoining(field, adjoining);
-    for (uint32_t i = 0; i < field_adjoining_size(field); ++i) {
-        if (field_owner(adjoining[i]) != 0) {
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t current_owner = field_owner(g->board, adjoining[i]);
+        if (current_owner != 0) {
             diff = 1;
-            for (uint32_t j = i + 1; j < field_adjoining_size(field); ++j) {
-                if (field_owner(adjoining[i]) == field_owner(adjoining[j])) {
+            for (uint32_t j = i + 1; j < size; ++j) {
+                if (current_owner == field_owner(g->board, adjoining[j])) {
                     diff = 0;
                     break;
                 }
             }
-            player_t *current = gamma_get_player(g, field_owner(adjoining[i]));
+            player_t *current = gamma_get_player(g, current_owner);
             if (ISNULL(current)) {
                 return;
             }
             current->free_adjoining += diff;
         }
     }
-    uint32_t count_adj;
-    for (uint32_t i = 0; i < field_adjoining_size(field); ++i) {
-        count_adj = field_count_adjoining_fields(adjoining[i], owner->id);
-        if (field_owner(adjoining[i]) == 0 && count_adj == 0) {
+    for (uint32_t i = 0; i < size; ++i) {
+        if (field_owner(g->board, adjoining[i]) == 0
+                && field_count_adjoining_fields(g->board, adjoining[i],
+                                                owner_id) == 0) {
             owner->free_adjoining--;
         }
     }
-    owner->areas -= 1 - field_count_adjoining_areas(field, owner->id);
+    owner->areas -= 1 - field_count_adjoining_areas(g->board, field, owner_id);
     owner->occupied_fields--;
     g->ocupied_fields--;
 }
@@ -186,24 +914,27 @@ static void gamma_release_field(gamma_t *g, field_t *field) {
  * W wyniku funkcji zajęte przez pewnego gracza pole staje się wolne.
  * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
  * @param[in] player        – wskaźnik do informacji związanych z graczem,
- * @param[in] field         – wskaźnik do informacji związanych polem.
+ * @param[in] field         – identyfikator pola.
  */
 static bool gamma_golden_move_possible(gamma_t *g, player_t *player,
-                                       field_t *field) {
-    if (ISNULL(player) || ISNULL(field)) {
+                                       field_t field) {
+    if (ISNULL(player) || field == FIELD_NONE) {
         return false;
     }
-    if (field_owner(field) == player->id || field_owner(field) == 0) {
+    uint32_t id = gamma_player_id(g, player);
+    uint32_t field_player = field_owner(g->board, field);
+    if (field_player == id || field_player == 0) {
         return false;
     }
     if (player->areas == g->areas_limit
-        && field_count_adjoining_areas(field, player->id) == 0) {
+        && field_count_adjoining_areas(g->board, field, id) == 0) {
         /* Gracz osiągnął limit obszarów i nie powiększy żadnego istniejącego.
         */
         return false;
     }
-    player_t *owner = gamma_get_player(g, field_owner(field));
-    uint32_t areas_after_breaking = field_count_adjoining_areas_after_breaking(field);
+    player_t *owner = gamma_get_player(g, field_player);
+    uint32_t areas_after_breaking =
+            field_count_adjoining_areas_after_breaking(g->board, field);
     if (g->areas_limit - owner->areas < ADJOINING_FIELDS && g->areas_limit <
                                                             areas_after_breaking - 1 + owner->areas) {
         /* Zdjęcie pionka innemu graczu stworzyłoby mu obszary ponad limit.
@@ -216,89 +947,788 @@ static bool gamma_golden_move_possible(gamma_t *g, player_t *player,
 
 gamma_t* gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas) {
-    if (width == 0 || height == 0 || players == 0 || areas == 0) {
-        return NULL;
+    return gamma_new_ext(width, height, players, areas, NULL);
+}
+
+
+/** @brief Sposób przechowywania planszy odpowiadający opcjom gry.
+ * @param[in] options       – opcje tworzenia gry lub `NULL`.
+ * @return Sposób przechowywania pól planszy.
+ */
+static board_storage_t gamma_board_storage(const gamma_options_t *options) {
+    if (ISNULL(options)) {
+        return BOARD_STORAGE_AUTO;
     }
-    /** W ramach alokacji struktury wykonywane są następujące czynności:
-     */
-    gamma_t *g = malloc(sizeof(struct gamma));
-    if (ISNULL(g)) {
-        return NULL;
+    switch (options->storage) {
+        case GAMMA_STORAGE_DENSE:
+            return BOARD_STORAGE_DENSE;
+        case GAMMA_STORAGE_SPARSE:
+            return BOARD_STORAGE_SPARSE;
+        case GAMMA_STORAGE_BITBOARD:
+            return BOARD_STORAGE_BITS;
+        default:
+            return BOARD_STORAGE_AUTO;
     }
-    /** 1. Alokacja i inicjacja informacji o graczach.
-     */
-    g->players = calloc(sizeof(player_t), players);
-    if (ISNULL(g->players)) {
-        free(g);
-        return NULL;
+}
+
+
+/** @brief Domyślne przydzielenie wyzerowanego bloku pamięci gry.
+ * Duże bloki mapowane są bezpośrednio z systemu bez rezerwowania pamięci,
+ * więc czas przydziału nie zależy od rozmiaru, a strony zajmują pamięć
+ * dopiero przy pierwszym zapisie. Mniejsze bloki przydziela `calloc`.
+ * @param[in] context       – nieużywany,
+ * @param[in] size          – rozmiar bloku w bajtach,
+ * @param[in] alignment     – wymagane wyrównanie bloku.
+ * @return Wskaźnik na blok lub `NULL` jeżeli nie udało się go przydzielić.
+ */
+static void *gamma_default_alloc(void *context, size_t size,
+                                 size_t alignment) {
+    (void) context;
+    if (size < MAP_THRESHOLD) {
+        return calloc(1, size);
     }
-    for (uint32_t i = 0; i < players; ++i) {
-        g->players[i].id = i + 1;
-        g->players[i].areas = 0;
-        g->players[i].occupied_fields = 0;
-        g->players[i].free_adjoining = 0;
-        g->players[i].golden_move_done = false;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    /* Mapowanie jest wyrównane do strony; większe wyrównanie uzyskujemy,
+     * mapując nadmiarowy obszar i zwalniając jego końce. */
+    size_t extra = alignment > page ? alignment : 0;
+    if (size > SIZE_MAX - extra - page) {
+        errno = ENOMEM;
+        return NULL;
     }
-    g->no_players = players;
-    /** 2. Alokacja i inicjacja pól na planszy.
-     */
-    g->width = width;
-    g->height = height;
-    g->fields = field_board_new(width, height);
-    if (ISNULL(g->fields)) {
-        free(g->players);
-        free(g);
+    size_t length = (size + extra + page - 1) / page * page;
+    char *result = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (result == MAP_FAILED) {
+        errno = ENOMEM;
         return NULL;
     }
-    /** 3. Zainicjowanie przechowywanych wartości pomocniczych.
-     */
-    g->areas_limit = areas;
-    g->ocupied_fields = 0;
-    return g;
+    if (extra > 0) {
+        size_t head = (alignment - (uintptr_t) result % alignment) % alignment;
+        size_t used = head + (size + page - 1) / page * page;
+        if (head > 0) {
+            munmap(result, head);
+        }
+        if (used < length) {
+            munmap(result + used, length - used);
+        }
+        result += head;
+    }
+    return result;
 }
 
 
-void gamma_delete(gamma_t *g) {
-    if (ISNULL(g)) {
-        return;
+/** @brief Zwolnienie bloku przydzielonego przez @ref gamma_default_alloc.
+ * @param[in] context       – nieużywany,
+ * @param[in] memory        – wskaźnik na blok,
+ * @param[in] size          – rozmiar bloku w bajtach.
+ */
+static void gamma_default_free(void *context, void *memory, size_t size) {
+    (void) context;
+    if (size < MAP_THRESHOLD) {
+        free(memory);
+    } else {
+        munmap(memory, size);
     }
-    free(g->players);
-    free(g->fields);
-    free(g);
 }
 
 
-bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    field_t *field = gamma_get_field(g, x, y);
-    player_t *player_info = gamma_get_player(g, player);
-    if (ISNULL(g) || ISNULL(field) || ISNULL(player_info) ||
-            field_owner(field) != 0) {
-        return false;
+/** @brief Przydzielenie bloku pamięci gry.
+ * Struktura gry leży na końcu bloku.
+ * @param[in] options       – opcje tworzenia gry lub `NULL`,
+ * @param[in] size          – rozmiar bloku bez struktury gry.
+ * @return Wskaźnik na wyzerowaną strukturę gry lub `NULL` jeżeli nie udało
+ * się przydzielić pamięci.
+ */
+static gamma_t *gamma_alloc(const gamma_options_t *options, uint64_t size) {
+    gamma_allocator_t allocator = { .alloc = gamma_default_alloc,
+                                    .free = gamma_default_free };
+    if (!ISNULL(options) && !ISNULL(options->allocator)) {
+        allocator = *options->allocator;
     }
-    uint32_t my_adjoining_areas = field_count_adjoining_areas(field, player);
-    if (player_info->areas == g->areas_limit && my_adjoining_areas == 0) {
-        return false;
+    if (size > SIZE_MAX - sizeof(struct gamma)) {
+        errno = ENOMEM;
+        return NULL;
     }
-    gamma_take_field(g, player_info, field);
-    return true;
-}
+    size += sizeof(struct gamma);
+    size_t alignment = size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE
+                                              : _Alignof(max_align_t);
+    char *memory = allocator.alloc(allocator.context, size, alignment);
+    if (ISNULL(memory)) {
+        return NULL;
+    }
+    gamma_t *g = (gamma_t *) (memory + size - sizeof(struct gamma));
+    g->allocator = allocator;
+    g->memory = memory;
+    g->memory_size = size;
+    return g;
+}
+
+
+/** @brief Zwolnienie bloku pamięci gry.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void gamma_free(gamma_t *g) {
+    gamma_allocator_t allocator = g->allocator;
+    allocator.free(allocator.context, g->memory, g->memory_size);
+}
+
+
+/** @brief Układ pól planszy odpowiadający opcjom gry.
+ * @param[in] options       – opcje tworzenia gry lub `NULL`.
+ * @return Układ pól planszy w pamięci.
+ */
+static board_layout_t gamma_board_layout(const gamma_options_t *options) {
+    if (!ISNULL(options) && options->layout == GAMMA_LAYOUT_SQUARES) {
+        return BOARD_LAYOUT_SQUARES;
+    }
+    return BOARD_LAYOUT_ROWS;
+}
+
+
+gamma_t* gamma_new_ext(uint32_t width, uint32_t height, uint32_t players,
+                       uint32_t areas, const gamma_options_t *options) {
+    if (width == 0 || height == 0 || players == 0 || areas == 0) {
+        return NULL;
+    }
+    bool in_file = !ISNULL(options) && !ISNULL(options->path);
+    if (in_file && (options->storage == GAMMA_STORAGE_SPARSE
+                    || options->storage == GAMMA_STORAGE_BITBOARD)) {
+        return NULL;
+    }
+    /** W ramach alokacji struktury wykonywane są następujące czynności:
+     */
+    /** 1. Przydzielenie jednego bloku pamięci na planszę, tablicę graczy
+     * i strukturę gry. Plansza leży na początku bloku, więc jej tablice mają
+     * wyrównanie bloku. Wyzerowane pola i gracze opisują początkowy stan gry.
+     */
+    uint64_t board_size = 0, players_size = 0;
+    if (!in_file) {
+        board_size = field_board_size(width, height, players,
+                                      gamma_board_storage(options),
+                                      gamma_board_layout(options));
+        if (board_size == 0) {
+            return NULL;
+        }
+        players_size = (uint64_t) players * sizeof(player_t);
+    }
+    if (board_size > SIZE_MAX - players_size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    gamma_t *g = gamma_alloc(options, board_size + players_size);
+    if (ISNULL(g)) {
+        return NULL;
+    }
+    g->width = width;
+    g->height = height;
+    g->no_players = players;
+    g->areas_limit = areas;
+    g->threads = ISNULL(options) ? 0 : options->threads;
+    /** 2. Utworzenie planszy. Gra przechowywana w pliku trzyma tam również
+     * tablicę graczy.
+     */
+    if (!in_file) {
+        g->board = field_board_init(g->memory, width, height, players,
+                                    gamma_board_storage(options),
+                                    gamma_board_layout(options));
+        g->players = (player_t *) ((char *) g->memory + board_size);
+        return g;
+    }
+    g->board = field_board_map(width, height, players,
+                               gamma_board_layout(options), options->path,
+                               sizeof(gamma_file_t)
+                               + (uint64_t) players * sizeof(player_t));
+    if (ISNULL(g->board)) {
+        gamma_free(g);
+        return NULL;
+    }
+    g->file = field_board_extra(g->board, NULL);
+    g->file->width = width;
+    g->file->height = height;
+    g->file->no_players = players;
+    g->players = g->file->players;
+    return g;
+}
+
+
+/** @brief Otwarcie gry przechowywanej w pliku.
+ * @param[in] path          – ścieżka do pliku planszy,
+ * @param[in] read_only     – @p true, jeżeli gra ma być otwarta tylko
+ *                            do odczytu.
+ * @return Wskaźnik na strukturę gry lub `NULL`, gdy nie udało się jej
+ * otworzyć.
+ */
+static gamma_t* gamma_open_file(const char *path, bool read_only) {
+    gamma_t *g = gamma_alloc(NULL, 0);
+    if (ISNULL(g)) {
+        return NULL;
+    }
+    g->read_only = read_only;
+    g->board = field_board_open(path, read_only);
+    uint64_t size = 0;
+    g->file = field_board_extra(g->board, &size);
+    if (ISNULL(g->file) || size < sizeof(gamma_file_t)
+            || size != sizeof(gamma_file_t)
+                       + (uint64_t) g->file->no_players * sizeof(player_t)) {
+        field_board_delete(g->board);
+        gamma_free(g);
+        return NULL;
+    }
+    g->width = g->file->width;
+    g->height = g->file->height;
+    g->no_players = g->file->no_players;
+    g->areas_limit = g->file->areas_limit;
+    g->ocupied_fields = g->file->ocupied_fields;
+    g->players = g->file->players;
+    for (uint32_t i = 0; i < g->no_players; ++i) {
+        /* Listy kandydatów zostaną odbudowane przy pierwszym zapytaniu. */
+        g->players[i].candidates = NULL;
+        g->players[i].candidates_size = 0;
+        g->players[i].candidates_capacity = 0;
+        g->players[i].candidates_lost = true;
+        g->players[i].candidates_listed = false;
+    }
+    return g;
+}
+
+
+gamma_t* gamma_open(const char *path) {
+    return gamma_open_file(path, false);
+}
+
+
+gamma_t* gamma_open_readonly(const char *path) {
+    return gamma_open_file(path, true);
+}
+
+
+gamma_t* gamma_clone(gamma_t *g) {
+    if (ISNULL(g)) {
+        return NULL;
+    }
+    board_storage_t storage = field_board_storage(g->board);
+    board_layout_t layout = field_board_layout(g->board);
+    uint64_t board_size = field_board_size(g->width, g->height, g->no_players,
+                                           storage, layout);
+    uint64_t players_size = (uint64_t) g->no_players * sizeof(player_t);
+    if (board_size == 0 || board_size > SIZE_MAX - players_size) {
+        return NULL;
+    }
+    gamma_options_t options = { .allocator = &g->allocator };
+    gamma_t *c = gamma_alloc(&options, board_size + players_size);
+    if (ISNULL(c)) {
+        return NULL;
+    }
+    c->width = g->width;
+    c->height = g->height;
+    c->no_players = g->no_players;
+    c->areas_limit = g->areas_limit;
+    c->ocupied_fields = g->ocupied_fields;
+    c->version = g->version;
+    c->threads = g->threads;
+    c->board = field_board_init(c->memory, g->width, g->height, g->no_players,
+                                storage, layout);
+    if (!field_board_copy(c->board, g->board)) {
+        field_board_delete(c->board);
+        gamma_free(c);
+        return NULL;
+    }
+    c->players = (player_t *) ((char *) c->memory + board_size);
+    memcpy(c->players, g->players, players_size);
+    for (uint32_t i = 0; i < c->no_players; ++i) {
+        /* Listy kandydatów zostaną odbudowane przy pierwszym zapytaniu. */
+        c->players[i].candidates = NULL;
+        c->players[i].candidates_size = 0;
+        c->players[i].candidates_capacity = 0;
+        c->players[i].candidates_lost = true;
+        c->players[i].candidates_listed = false;
+        c->players[i].candidates_next = 0;
+    }
+    return c;
+}
+
+
+/** @brief Rozmiar identyfikatora właściciela pola w migawce gry.
+ * @param[in] players       – liczba graczy.
+ * @return Liczba bajtów potrzebna do zapisania identyfikatora gracza.
+ */
+static uint32_t gamma_snapshot_owner_size(uint32_t players) {
+    if (players <= UINT8_MAX) {
+        return sizeof(uint8_t);
+    }
+    return players <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+
+bool gamma_save(gamma_t *g, FILE *stream) {
+    if (ISNULL(g) || ISNULL(stream)) {
+        return false;
+    }
+    gamma_snapshot_t header = {
+            .magic = SNAPSHOT_MAGIC, .version = SNAPSHOT_VERSION,
+            .owner_size = gamma_snapshot_owner_size(g->no_players),
+            .height = g->height, .width = g->width,
+            .no_players = g->no_players, .areas_limit = g->areas_limit,
+            .ocupied_fields = g->ocupied_fields };
+    if (fwrite(&header, sizeof(header), 1, stream) != 1) {
+        return false;
+    }
+    uint32_t owners[BOARD_CHUNK];
+    for (uint32_t y = 0; y < g->height; ++y) {
+        for (uint32_t x = 0; x < g->width; x += BOARD_CHUNK) {
+            uint32_t count = g->width - x < BOARD_CHUNK ? g->width - x
+                                                        : BOARD_CHUNK;
+            field_owners(g->board, x, y, count, owners);
+            bool empty = true;
+            for (uint32_t i = 0; i < count; ++i) {
+                empty &= owners[i] == 0;
+            }
+            if (fputc(empty ? SNAPSHOT_FREE : SNAPSHOT_RAW, stream) == EOF) {
+                return false;
+            }
+            if (empty) {
+                continue;
+            }
+            /* Identyfikatory zwężane są w miejscu do rozmiaru z nagłówka. */
+            for (uint32_t i = 0; i < count; ++i) {
+                if (header.owner_size == sizeof(uint8_t)) {
+                    ((uint8_t *) owners)[i] = (uint8_t) owners[i];
+                } else if (header.owner_size == sizeof(uint16_t)) {
+                    ((uint16_t *) owners)[i] = (uint16_t) owners[i];
+                }
+            }
+            if (fwrite(owners, header.owner_size, count, stream) != count) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < g->no_players; ++i) {
+        const player_t *player = &g->players[i];
+        gamma_snapshot_player_t record = {
+                .occupied_fields = player->occupied_fields,
+                .free_adjoining = player->free_adjoining,
+                .enemy_adjoining = player->enemy_adjoining,
+                .areas = player->areas,
+                .golden_move_done = player->golden_move_done };
+        if (fwrite(&record, sizeof(record), 1, stream) != 1) {
+            return false;
+        }
+    }
+    return fflush(stream) == 0;
+}
+
+
+/** Liczba wierszy i kolumn otoczenia odcinka wiersza, od których zależą
+ * liczniki sąsiedztwa jego pól. */
+#define LOAD_MARGIN 2
+
+
+/** @brief Sprawdzenie czy pole okna leży na planszy.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x             – numer kolumny pierwszego pola odcinka,
+ * @param[in] y             – numer wiersza odcinka,
+ * @param[in] row           – numer wiersza okna,
+ * @param[in] column        – numer kolumny okna.
+ * @return Wartość @p true, jeżeli pole leży na planszy.
+ */
+static bool gamma_window_inside(const gamma_t *g, uint32_t x, uint32_t y,
+                                uint32_t row, uint32_t column) {
+    uint64_t board_x = (uint64_t) x + column, board_y = (uint64_t) y + row;
+    return board_x >= LOAD_MARGIN && board_x - LOAD_MARGIN < g->width
+           && board_y >= LOAD_MARGIN && board_y - LOAD_MARGIN < g->height;
+}
+
+
+/** @brief Przeliczenie liczników sąsiedztwa graczy po wczytaniu planszy.
+ * Każde zajęte pole wczytanych odcinków dolicza się do liczników
+ * przylegających do niego graczy i tych wolnych pól, dla których jest
+ * pierwszym polem swojego gracza w kolejności: góra, lewo, prawo, dół – więc
+ * każde wolne pole liczone jest raz. Właściciele pól odczytywani są całymi
+ * odcinkami wraz z otoczeniem szerokości @ref LOAD_MARGIN.
+ * @param[in, out] g        – wskaźnik na grę z wczytaną planszą i zerowymi
+ *                            licznikami sąsiedztwa,
+ * @param[in] chunks        – pierwsze pola odcinków z zajętymi polami,
+ * @param[in] size          – liczba odcinków.
+ */
+static void gamma_load_counters(gamma_t *g, const field_t *chunks,
+                                uint64_t size) {
+    static const int32_t dx[ADJOINING_FIELDS] = {0, -1, 1, 0};
+    static const int32_t dy[ADJOINING_FIELDS] = {-1, 0, 0, 1};
+    uint32_t window[2 * LOAD_MARGIN + 1][BOARD_CHUNK + 2 * LOAD_MARGIN];
+    for (uint64_t i = 0; i < size; ++i) {
+        uint32_t x = field_column(chunks[i]), y = field_row(chunks[i]);
+        uint32_t count = g->width - x < BOARD_CHUNK ? g->width - x
+                                                    : BOARD_CHUNK;
+        uint32_t left = x < LOAD_MARGIN ? x : LOAD_MARGIN;
+        uint32_t right = g->width - x - count < LOAD_MARGIN ?
+                         g->width - x - count : LOAD_MARGIN;
+        /* Pola poza planszą mają w oknie właściciela 0. */
+        memset(window, 0, sizeof(window));
+        for (uint32_t row = 0; row <= 2 * LOAD_MARGIN; ++row) {
+            if (gamma_window_inside(g, x, y, row, LOAD_MARGIN)) {
+                field_owners(g->board, x - left, y + row - LOAD_MARGIN,
+                             left + count + right,
+                             window[row] + LOAD_MARGIN - left);
+            }
+        }
+        for (uint32_t c = LOAD_MARGIN; c < LOAD_MARGIN + count; ++c) {
+            uint32_t owner = window[LOAD_MARGIN][c];
+            if (owner == 0) {
+                continue;
+            }
+            uint32_t enemies[ADJOINING_FIELDS];
+            uint32_t enemies_size = 0;
+            for (uint32_t k = 0; k < ADJOINING_FIELDS; ++k) {
+                uint32_t row = LOAD_MARGIN + dy[k], column = c + dx[k];
+                uint32_t current = window[row][column];
+                if (current == 0) {
+                    if (!gamma_window_inside(g, x, y, row, column)) {
+                        continue;
+                    }
+                    uint32_t j = 0;
+                    while (window[row + dy[j]][column + dx[j]] != owner) {
+                        j++;
+                    }
+                    if (dy[j] == -dy[k] && dx[j] == -dx[k]) {
+                        g->players[owner - 1].free_adjoining++;
+                    }
+                    continue;
+                }
+                bool add = current != owner;
+                for (uint32_t j = 0; j < enemies_size && add; ++j) {
+                    add = enemies[j] != current;
+                }
+                if (add) {
+                    enemies[enemies_size++] = current;
+                    g->players[current - 1].enemy_adjoining++;
+                }
+            }
+        }
+    }
+}
+
+
+/** @brief Wczytanie pól planszy z migawki gry.
+ * Pola zajmowane są bezpośrednio na planszy. Liczniki zajętych pól
+ * i obszarów graczy aktualizowane są przy zajmowaniu pól, a liczniki
+ * sąsiedztwa przeliczane funkcją @ref gamma_load_counters, więc wszystkie
+ * odpowiadają wczytanej planszy.
+ * @param[in, out] g        – wskaźnik na nowo utworzoną grę,
+ * @param[in] stream        – strumień wejściowy,
+ * @param[in] owner_size    – rozmiar identyfikatora właściciela pola.
+ * @return Wartość @p true jeżeli udało się wczytać poprawną planszę.
+ */
+static bool gamma_load_fields(gamma_t *g, FILE *stream, uint32_t owner_size) {
+    uint32_t owners[BOARD_CHUNK];
+    field_t *chunks = NULL;
+    uint64_t chunks_size = 0, chunks_capacity = 0;
+    bool valid = true;
+    for (uint32_t y = 0; y < g->height && valid; ++y) {
+        for (uint32_t x = 0; x < g->width && valid; x += BOARD_CHUNK) {
+            uint32_t count = g->width - x < BOARD_CHUNK ? g->width - x
+                                                        : BOARD_CHUNK;
+            int tag = fgetc(stream);
+            if (tag == SNAPSHOT_FREE) {
+                continue;
+            }
+            if (tag != SNAPSHOT_RAW
+                    || fread(owners, owner_size, count, stream) != count) {
+                valid = false;
+                break;
+            }
+            if (chunks_size == chunks_capacity) {
+                uint64_t capacity = chunks_capacity == 0 ?
+                                    ADJOINING_FIELDS : chunks_capacity * 2;
+                field_t *resized = realloc(chunks, capacity * sizeof(field_t));
+                if (ISNULL(resized)) {
+                    valid = false;
+                    break;
+                }
+                chunks = resized;
+                chunks_capacity = capacity;
+            }
+            chunks[chunks_size++] = field_at(x, y);
+            /* Identyfikatory poszerzane są w miejscu od końca odcinka. */
+            for (uint32_t i = count; i-- > 0;) {
+                if (owner_size == sizeof(uint8_t)) {
+                    owners[i] = ((const uint8_t *) owners)[i];
+                } else if (owner_size == sizeof(uint16_t)) {
+                    owners[i] = ((const uint16_t *) owners)[i];
+                }
+            }
+            for (uint32_t i = 0; i < count && valid; ++i) {
+                if (owners[i] == 0) {
+                    continue;
+                }
+                field_t field = field_at(x + i, y);
+                valid = owners[i] <= g->no_players
+                        && field_reserve(g->board, field);
+                if (valid) {
+                    player_t *player = &g->players[owners[i] - 1];
+                    player->areas += 1 - field_count_adjoining_areas(
+                            g->board, field, owners[i]);
+                    field_take(g->board, field, owners[i]);
+                    player->occupied_fields++;
+                    g->ocupied_fields++;
+                }
+            }
+        }
+    }
+    if (valid) {
+        gamma_load_counters(g, chunks, chunks_size);
+    }
+    free(chunks);
+    return valid;
+}
+
+
+gamma_t* gamma_load(FILE *stream, const gamma_options_t *options) {
+    if (ISNULL(stream)) {
+        return NULL;
+    }
+    gamma_snapshot_t header;
+    if (fread(&header, sizeof(header), 1, stream) != 1
+            || header.magic != SNAPSHOT_MAGIC
+            || header.version != SNAPSHOT_VERSION
+            || header.owner_size
+               != gamma_snapshot_owner_size(header.no_players)) {
+        return NULL;
+    }
+    gamma_t *g = gamma_new_ext(header.width, header.height, header.no_players,
+                               header.areas_limit, options);
+    if (ISNULL(g)) {
+        return NULL;
+    }
+    bool valid = gamma_load_fields(g, stream, header.owner_size)
+                 && g->ocupied_fields == header.ocupied_fields;
+    for (uint32_t i = 0; valid && i < g->no_players; ++i) {
+        gamma_snapshot_player_t record;
+        player_t *player = &g->players[i];
+        /* Liczniki policzone przy wczytywaniu pól muszą zgadzać się
+         * z zapisanymi. */
+        valid = fread(&record, sizeof(record), 1, stream) == 1
+                && record.occupied_fields == player->occupied_fields
+                && record.free_adjoining == player->free_adjoining
+                && record.enemy_adjoining == player->enemy_adjoining
+                && record.areas == player->areas
+                && player->areas <= g->areas_limit;
+        player->golden_move_done = record.golden_move_done != 0;
+        /* Lista kandydatów zostanie odbudowana przy pierwszym zapytaniu. */
+        player->candidates_lost = true;
+    }
+    if (!valid) {
+        gamma_delete(g);
+        return NULL;
+    }
+    return g;
+}
+
+
+void gamma_delete(gamma_t *g) {
+    if (ISNULL(g)) {
+        return;
+    }
+    for (uint32_t id = g->candidates_head; id != 0;
+         id = g->players[id - 1].candidates_next) {
+        free(g->players[id - 1].candidates);
+        g->players[id - 1].candidates = NULL;
+    }
+    free(g->dirty);
+    free(g->changes);
+    free(g->counters);
+    free(g->taken_map);
+    free(g->full_map);
+    if (!ISNULL(g->frontiers)) {
+        for (uint32_t i = 0; i < g->no_players; ++i) {
+            free(g->frontiers[i].fields);
+        }
+        free(g->frontiers);
+    }
+    if (!ISNULL(g->file) && !g->read_only) {
+        g->file->areas_limit = g->areas_limit;
+        g->file->ocupied_fields = g->ocupied_fields;
+    }
+    field_board_delete(g->board);
+    gamma_free(g);
+}
+
+
+/** @brief Rozpoczęcie zmiany stanu gry.
+ * Licznik sekwencji staje się nieparzysty, więc czytelnicy z innych wątków
+ * czekają na koniec zmiany albo powtarzają rozpoczęty odczyt. Zapisy
+ * wykonywane są bez blokad.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void gamma_write_begin(gamma_t *g) {
+    uint64_t sequence = atomic_load_explicit(&g->sequence,
+                                             memory_order_relaxed);
+    atomic_store_explicit(&g->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+
+/** @brief Zakończenie zmiany stanu gry.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry.
+ */
+static void gamma_write_end(gamma_t *g) {
+    uint64_t sequence = atomic_load_explicit(&g->sequence,
+                                             memory_order_relaxed);
+    atomic_store_explicit(&g->sequence, sequence + 1, memory_order_release);
+}
+
+
+bool gamma_reset(gamma_t *g) {
+    if (ISNULL(g) || g->read_only) {
+        return false;
+    }
+    gamma_write_begin(g);
+    if (!field_board_reset(g->board)) {
+        gamma_write_end(g);
+        return false;
+    }
+    for (uint32_t i = 0; i < g->no_players; ++i) {
+        player_t *player = &g->players[i];
+        /* Tablica kandydatów zostaje do ponownego użycia. */
+        player->golden_move_done = false;
+        player->occupied_fields = 0;
+        player->free_adjoining = 0;
+        player->areas = 0;
+        player->enemy_adjoining = 0;
+        player->candidates_size = 0;
+        player->candidates_lost = false;
+    }
+    g->ocupied_fields = 0;
+    g->version++;
+    g->dirty_lost = true;
+    g->dirty_size = 0;
+    g->changes_size = 0;
+    g->changes_count = 0;
+    if (!ISNULL(g->taken_map)) {
+        memset(g->taken_map, 0, g->row_words * g->height * sizeof(uint64_t));
+        memset(g->full_map, 0, (g->row_words * g->height / WORD_BITS + 1)
+                               * sizeof(uint64_t));
+        for (uint32_t y = 0; y < g->height && g->width % WORD_BITS != 0; ++y) {
+            g->taken_map[(y + 1) * g->row_words - 1] =
+                    UINT64_MAX << (g->width % WORD_BITS);
+        }
+    }
+    /* Na pustej planszy utworzone listy wolnych pól są puste i pozostają
+     * utrzymywane. */
+    for (uint32_t i = 0; !ISNULL(g->frontiers) && i < g->no_players; ++i) {
+        g->frontiers[i].size = 0;
+    }
+    gamma_write_end(g);
+    return true;
+}
+
+
+gamma_pool_t* gamma_pool_new(size_t capacity) {
+    if (capacity == 0 || capacity > SIZE_MAX / sizeof(gamma_t *)) {
+        return NULL;
+    }
+    gamma_pool_t *pool = malloc(sizeof(gamma_pool_t));
+    if (ISNULL(pool)) {
+        return NULL;
+    }
+    pool->games = malloc(capacity * sizeof(gamma_t *));
+    if (ISNULL(pool->games)) {
+        free(pool);
+        return NULL;
+    }
+    pool->size = 0;
+    pool->capacity = capacity;
+    return pool;
+}
+
+
+void gamma_pool_delete(gamma_pool_t *pool) {
+    if (ISNULL(pool)) {
+        return;
+    }
+    for (size_t i = 0; i < pool->size; ++i) {
+        gamma_delete(pool->games[i]);
+    }
+    free(pool->games);
+    free(pool);
+}
+
+
+gamma_t* gamma_pool_get(gamma_pool_t *pool, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas) {
+    if (ISNULL(pool) || areas == 0) {
+        return NULL;
+    }
+    /* Ostatnio oddane silniki mają najpewniej swoją pamięć w pamięci
+     * podręcznej procesora. */
+    for (size_t i = pool->size; i-- > 0;) {
+        gamma_t *g = pool->games[i];
+        if (g->width == width && g->height == height
+                && g->no_players == players) {
+            pool->games[i] = pool->games[--pool->size];
+            g->areas_limit = areas;
+            return g;
+        }
+    }
+    return gamma_new(width, height, players, areas);
+}
+
+
+void gamma_pool_put(gamma_pool_t *pool, gamma_t *g) {
+    if (ISNULL(g)) {
+        return;
+    }
+    if (ISNULL(pool) || pool->size == pool->capacity || !ISNULL(g->file)
+            || !gamma_set_journal(g, false) || !gamma_reset(g)) {
+        gamma_delete(g);
+        return;
+    }
+    pool->games[pool->size++] = g;
+}
+
+
+bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
+    field_t field = gamma_get_field(g, x, y);
+    player_t *player_info = gamma_get_player(g, player);
+    if (ISNULL(g) || g->read_only || field == FIELD_NONE
+            || ISNULL(player_info) || field_owner(g->board, field) != 0) {
+        return false;
+    }
+    uint32_t my_adjoining_areas = field_count_adjoining_areas(g->board, field,
+                                                              player);
+    if (player_info->areas == g->areas_limit && my_adjoining_areas == 0) {
+        return false;
+    }
+    if (!field_reserve(g->board, field)) {
+        return false;
+    }
+    gamma_write_begin(g);
+    gamma_journal_begin(g, player_info, field, false);
+    gamma_take_field(g, player_info, field);
+    gamma_write_end(g);
+    return true;
+}
 
 
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
-    if (ISNULL(g) || !test_player(g, player) || !test_field(g, x, y)) {
+    if (ISNULL(g) || g->read_only || !test_player(g, player)
+            || !test_field(g, x, y)) {
         return false;
     }
     player_t *player_link = gamma_get_player(g, player);
-    field_t *field = gamma_get_field(g, x, y);
+    field_t field = gamma_get_field(g, x, y);
     if (player_link->golden_move_done) {
         /* Złoty ruch został już wykonany przez tego gracza.
          */
         return false;
     }
-    if (gamma_golden_move_possible(g, player_link, field)) {
+    if (gamma_golden_move_possible(g, player_link, field)
+            && field_reserve(g->board, field)) {
+        gamma_write_begin(g);
+        gamma_journal_begin(g, player_link, field, true);
         gamma_release_field(g, field);
         gamma_take_field(g, player_link, field);
         player_link->golden_move_done = true;
+        gamma_write_end(g);
         return true;
     } else {
         return false;
@@ -306,23 +1736,514 @@ bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
 }
 
 
-uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
-    if (ISNULL(g) || !test_player(g, player)) {
-        return 0;
+bool gamma_set_journal(gamma_t *g, bool enabled) {
+    if (ISNULL(g) || (enabled && g->read_only)) {
+        return false;
+    }
+    if (!enabled) {
+        field_journal_stop(g->board);
+        free(g->changes);
+        free(g->counters);
+        g->changes = NULL;
+        g->counters = NULL;
+        g->changes_capacity = 0;
+        g->counters_capacity = 0;
+    } else {
+        field_journal_start(g->board);
+    }
+    g->journal = enabled;
+    g->changes_size = 0;
+    g->changes_count = 0;
+    return true;
+}
+
+
+bool gamma_undo(gamma_t *g) {
+    if (ISNULL(g) || g->changes_size == 0) {
+        return false;
+    }
+    if (field_journal_changes(g->board) != g->changes_size) {
+        /* Zabrakło pamięci na dziennik planszy. */
+        g->changes_size = 0;
+        g->changes_count = 0;
+        return false;
+    }
+    const gamma_change_t *change = &g->changes[g->changes_size - 1];
+    gamma_write_begin(g);
+    if (!field_journal_undo(g->board)) {
+        gamma_write_end(g);
+        return false;
+    }
+    for (uint32_t i = 0; i < change->counters_size; ++i) {
+        const gamma_counters_t *saved = &g->counters[change->counters + i];
+        player_t *player = &g->players[saved->player - 1];
+        player->golden_move_done = saved->golden_move_done;
+        player->areas = saved->areas;
+        player->occupied_fields = saved->occupied_fields;
+        player->free_adjoining = saved->free_adjoining;
+        player->enemy_adjoining = saved->enemy_adjoining;
+    }
+    if (change->golden) {
+        /* Pole wróciło do poprzedniego właściciela, więc trzeba je znów
+         * dopisać do list kandydatów; para wywołań nie zmienia odtworzonych
+         * liczników. */
+        gamma_update_candidates(g, change->field, false);
+        gamma_update_candidates(g, change->field, true);
+    } else {
+        g->ocupied_fields--;
+    }
+    gamma_dirty_push(g, change->field);
+    gamma_moves_update(g, change->field);
+    g->version++;
+    g->changes_size--;
+    gamma_write_end(g);
+    return true;
+}
+
+
+bool gamma_redo(gamma_t *g) {
+    if (ISNULL(g) || g->changes_size == g->changes_count) {
+        return false;
+    }
+    const gamma_change_t *change = &g->changes[g->changes_size];
+    uint32_t x = field_column(change->field), y = field_row(change->field);
+    return change->golden ? gamma_golden_move(g, change->player, x, y)
+                          : gamma_move(g, change->player, x, y);
+}
+
+
+uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
+    if (ISNULL(g) || !test_player(g, player)) {
+        return 0;
+    }
+    return gamma_get_player(g, player)->occupied_fields;
+}
+
+
+uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
+    player_t *player_info = gamma_get_player(g, player);
+    if (ISNULL(player_info)) {
+        return 0;
+    }
+    if (player_info->areas == g->areas_limit) {
+        return player_info->free_adjoining;
+    } else {
+        return (uint64_t) g->width * g->height - g->ocupied_fields;
+    }
+}
+
+
+/** @brief Utworzenie bitmapy zajętych pól.
+ * Bitmapa składa się z dwóch poziomów: bitów pól oraz bitów słów, w których
+ * nie ma wolnych pól, dzięki czemu wyszukiwanie wolnych pól pomija zajęte
+ * fragmenty planszy po 4096 pól naraz.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeżeli bitmapa została utworzona, @p false, jeżeli
+ * zabrakło pamięci.
+ */
+static bool gamma_taken_build(gamma_t *g) {
+    uint64_t row_words = ((uint64_t) g->width + WORD_BITS - 1) / WORD_BITS;
+    uint64_t words = row_words * g->height;
+    if (words > SIZE_MAX / sizeof(uint64_t)) {
+        return false;
+    }
+    g->taken_map = calloc(words, sizeof(uint64_t));
+    g->full_map = calloc(words / WORD_BITS + 1, sizeof(uint64_t));
+    if (ISNULL(g->taken_map) || ISNULL(g->full_map)) {
+        free(g->taken_map);
+        free(g->full_map);
+        g->taken_map = NULL;
+        g->full_map = NULL;
+        return false;
+    }
+    g->row_words = row_words;
+    uint32_t owners[BOARD_CHUNK];
+    for (uint32_t y = 0; y < g->height; ++y) {
+        uint64_t *row = g->taken_map + y * row_words;
+        for (uint32_t x = 0; x < g->width; x += BOARD_CHUNK) {
+            uint32_t count = g->width - x < BOARD_CHUNK ? g->width - x
+                                                        : BOARD_CHUNK;
+            field_owners(g->board, x, y, count, owners);
+            for (uint32_t i = 0; i < count; ++i) {
+                if (owners[i] != 0) {
+                    row[(x + i) / WORD_BITS] |=
+                        (uint64_t) 1 << ((x + i) % WORD_BITS);
+                }
+            }
+        }
+        if (g->width % WORD_BITS != 0) {
+            row[row_words - 1] |= UINT64_MAX << (g->width % WORD_BITS);
+        }
+    }
+    for (uint64_t w = 0; w < words; ++w) {
+        if (g->taken_map[w] == UINT64_MAX) {
+            g->full_map[w / WORD_BITS] |= (uint64_t) 1 << (w % WORD_BITS);
+        }
+    }
+    return true;
+}
+
+
+/** @brief Utworzenie listy wolnych pól przylegających do pól gracza.
+ * Jeżeli zabraknie pamięci, lista pozostaje nieutworzona.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza.
+ */
+static void gamma_frontier_build(gamma_t *g, uint32_t id) {
+    if (ISNULL(g->frontiers)) {
+        g->frontiers = calloc(g->no_players, sizeof(gamma_frontier_t));
+        if (ISNULL(g->frontiers)) {
+            return;
+        }
+    }
+    g->frontiers[id - 1].built = true;
+    for (uint32_t h = 0; h < g->height; ++h) {
+        for (uint32_t w = 0; w < g->width; ++w) {
+            field_t f = gamma_get_field(g, w, h);
+            if (gamma_frontier_valid(g, id, f)) {
+                gamma_frontier_push(g, id, f);
+            }
+        }
+    }
+}
+
+
+/** @brief Wyszukanie słowa bitmapy zajętych pól z wolnym polem.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] word          – numer pierwszego sprawdzanego słowa,
+ * @param[in] words         – liczba słów bitmapy.
+ * @return Numer pierwszego słowa, nie mniejszego od @p word, w którym jest
+ * wolne pole, lub wartość nie mniejsza od @p words, jeżeli takiego nie ma.
+ */
+static uint64_t gamma_free_word(const gamma_t *g, uint64_t word,
+                                uint64_t words) {
+    while (word < words) {
+        uint64_t bits = ~g->full_map[word / WORD_BITS]
+                        & (UINT64_MAX << (word % WORD_BITS));
+        if (bits != 0) {
+            return word / WORD_BITS * WORD_BITS
+                   + (uint64_t) __builtin_ctzll(bits);
+        }
+        word = (word / WORD_BITS + 1) * WORD_BITS;
+    }
+    return words;
+}
+
+
+/** @brief Wypisanie wolnych pól na podstawie bitmapy zajętych pól.
+ * Kursor jest numerem bitu bitmapy, od którego należy kontynuować.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] cursor   – kursor wyliczania,
+ * @param[out] moves        – tablica na współrzędne pól,
+ * @param[in] capacity      – rozmiar tablicy @p moves.
+ * @return Liczba wypisanych pól.
+ */
+static size_t gamma_legal_free(const gamma_t *g, uint64_t *cursor,
+                               gamma_coords_t *moves, size_t capacity) {
+    uint64_t words = g->row_words * g->height;
+    size_t count = 0;
+    while (count < capacity && *cursor / WORD_BITS < words) {
+        uint64_t word = *cursor / WORD_BITS;
+        uint64_t bits = ~g->taken_map[word]
+                        & (UINT64_MAX << (*cursor % WORD_BITS));
+        if (bits == 0) {
+            word = gamma_free_word(g, word + 1, words);
+            *cursor = (word < words ? word : words) * WORD_BITS;
+            continue;
+        }
+        uint64_t bit = (uint64_t) __builtin_ctzll(bits);
+        moves[count].x = (uint32_t) ((word % g->row_words) * WORD_BITS + bit);
+        moves[count].y = (uint32_t) (word / g->row_words);
+        count++;
+        *cursor = word * WORD_BITS + bit + 1;
+    }
+    return count;
+}
+
+
+/** @brief Wypisanie legalnych ruchów gracza przeglądaniem planszy.
+ * Używane, gdy zabrakło pamięci na bitmapę lub listę pól. Kursor jest
+ * numerem pola w kolejności wierszowej.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza,
+ * @param[in] adjoining     – informacja o tym czy wypisywane są tylko pola
+ *                            przylegające do pól gracza,
+ * @param[in, out] cursor   – kursor wyliczania,
+ * @param[out] moves        – tablica na współrzędne pól,
+ * @param[in] capacity      – rozmiar tablicy @p moves.
+ * @return Liczba wypisanych pól.
+ */
+static size_t gamma_legal_scan(const gamma_t *g, uint32_t id, bool adjoining,
+                               uint64_t *cursor, gamma_coords_t *moves,
+                               size_t capacity) {
+    uint64_t fields = (uint64_t) g->width * g->height;
+    size_t count = 0;
+    for (; count < capacity && *cursor < fields; ++*cursor) {
+        uint32_t x = (uint32_t) (*cursor % g->width);
+        uint32_t y = (uint32_t) (*cursor / g->width);
+        field_t f = gamma_get_field(g, x, y);
+        if (adjoining ? gamma_frontier_valid(g, id, f)
+                      : field_owner(g->board, f) == 0) {
+            moves[count].x = x;
+            moves[count].y = y;
+            count++;
+        }
+    }
+    return count;
+}
+
+
+size_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *cursor,
+                         gamma_coords_t *moves, size_t capacity) {
+    player_t *player_info = gamma_get_player(g, player);
+    if (ISNULL(player_info) || ISNULL(cursor) || ISNULL(moves)) {
+        return 0;
+    }
+    if (player_info->areas < g->areas_limit) {
+        if (*cursor == 0 && ISNULL(g->taken_map)) {
+            gamma_taken_build(g);
+        }
+        if (ISNULL(g->taken_map)) {
+            return gamma_legal_scan(g, player, false, cursor, moves, capacity);
+        }
+        return gamma_legal_free(g, cursor, moves, capacity);
+    }
+    if (*cursor == 0) {
+        if (ISNULL(g->frontiers) || !g->frontiers[player - 1].built) {
+            gamma_frontier_build(g, player);
+        }
+        if (!ISNULL(g->frontiers) && g->frontiers[player - 1].built) {
+            /* Po uporządkowaniu lista zawiera dokładnie legalne ruchy. */
+            gamma_frontier_compact(g, player);
+        }
+    }
+    if (ISNULL(g->frontiers) || !g->frontiers[player - 1].built) {
+        return gamma_legal_scan(g, player, true, cursor, moves, capacity);
+    }
+    const gamma_frontier_t *frontier = &g->frontiers[player - 1];
+    size_t count = 0;
+    for (; count < capacity && *cursor < frontier->size; ++*cursor) {
+        field_t f = frontier->fields[*cursor];
+        moves[count].x = field_column(f);
+        moves[count].y = field_row(f);
+        count++;
+    }
+    return count;
+}
+
+
+/** @brief Wyszukanie złotego ruchu wśród kandydatów gracza.
+ * Funkcja usuwa z listy kandydatów pola, które przestały przylegać do pól
+ * gracza, a gdy lista zawiera zbyt wiele powtórzeń – także powtórzenia.
+ * Znalezione pole przenoszone jest na początek listy, żeby kolejne zapytania
+ * o niezmieniony stan gry kończyły się od razu.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] player   – wskaźnik do informacji związanych z graczem.
+ * @return Wartość @p true, jeżeli któryś z kandydatów jest polem na którym
+ * gracz może wykonać złoty ruch, @p false w przeciwnym wypadku.
+ */
+static bool gamma_golden_candidates(gamma_t *g, player_t *player) {
+    uint32_t id = gamma_player_id(g, player);
+    uint64_t valid = 0;
+    for (uint64_t i = 0; i < player->candidates_size; ++i) {
+        field_t f = player->candidates[i];
+        uint32_t owner = field_owner(g->board, f);
+        if (owner != 0 && owner != id
+                && field_count_adjoining_fields(g->board, f, id) > 0) {
+            player->candidates[valid++] = f;
+        }
+    }
+    player->candidates_size = valid;
+    if (player->candidates_size > 2 * player->enemy_adjoining) {
+        qsort(player->candidates, player->candidates_size, sizeof(field_t),
+              gamma_field_compare);
+        valid = 0;
+        for (uint64_t i = 0; i < player->candidates_size; ++i) {
+            if (valid == 0 || player->candidates[valid - 1]
+                              != player->candidates[i]) {
+                player->candidates[valid++] = player->candidates[i];
+            }
+        }
+        player->candidates_size = valid;
+    }
+    for (uint64_t i = 0; i < player->candidates_size; ++i) {
+        if (gamma_golden_move_possible(g, player, player->candidates[i])) {
+            field_t tmp = player->candidates[0];
+            player->candidates[0] = player->candidates[i];
+            player->candidates[i] = tmp;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** @brief Liczba wątków przeglądających planszę.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry.
+ * @return Liczba wątków lub `0` dla plansz zbyt małych, żeby opłacało się
+ * przeglądać je pasami.
+ */
+static uint32_t gamma_scan_threads(const gamma_t *g) {
+    if ((uint64_t) g->width * g->height < PARALLEL_FIELDS) {
+        return 0;
+    }
+    uint64_t threads = g->threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (uint64_t) online : 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    return threads > g->height ? g->height : (uint32_t) threads;
+}
+
+
+/** @brief Dopisanie pola do kandydatów znalezionych w pasie planszy.
+ * @param[in, out] band     – opis pasa,
+ * @param[in] field         – identyfikator pola.
+ * @return Wartość @p true, jeżeli pole zostało dopisane, @p false, jeżeli
+ * zabrakło pamięci.
+ */
+static bool gamma_band_push(gamma_band_t *band, field_t field) {
+    if (band->size == band->capacity) {
+        uint64_t capacity = band->capacity == 0 ? BOARD_CHUNK
+                                                : band->capacity * 2;
+        field_t *fields = realloc(band->fields, capacity * sizeof(field_t));
+        if (ISNULL(fields)) {
+            return false;
+        }
+        band->fields = fields;
+        band->capacity = capacity;
+    }
+    band->fields[band->size++] = field;
+    return true;
+}
+
+
+/** @brief Przejrzenie pasa planszy w poszukiwaniu kandydatów na złoty ruch.
+ * Wiersze pasa przeglądane są kolejno, odcinkami tablic planszy. Funkcja
+ * jedynie czyta stan gry, więc może działać równolegle dla różnych pasów.
+ * Po znalezieniu pola, na którym na pewno można wykonać złoty ruch, lub
+ * gdy zabraknie pamięci, ustawia wspólną flagę kończącą przeglądanie.
+ * @param[in, out] arg      – wskaźnik na opis pasa.
+ * @return Wartość `NULL`.
+ */
+static void *gamma_band_scan(void *arg) {
+    gamma_band_t *band = arg;
+    const gamma_t *g = band->g;
+    uint32_t owners[BOARD_CHUNK];
+    for (uint32_t y = band->first_row; y < band->last_row; ++y) {
+        if (atomic_load_explicit(band->stop, memory_order_relaxed)) {
+            return NULL;
+        }
+        for (uint32_t x = 0; x < g->width; x += BOARD_CHUNK) {
+            uint32_t count = g->width - x < BOARD_CHUNK ? g->width - x
+                                                        : BOARD_CHUNK;
+            field_owners(g->board, x, y, count, owners);
+            for (uint32_t i = 0; i < count; ++i) {
+                if (owners[i] == 0 || owners[i] == band->id) {
+                    continue;
+                }
+                field_t f = field_at(x + i, y);
+                if (field_count_adjoining_fields(g->board, f, band->id) == 0) {
+                    continue;
+                }
+                /* Zdjęcie pionka nie przekroczy limitu obszarów właściciela,
+                 * gdy ma on zapas na wszystkie części obszaru. */
+                if (band->stop_on_hit && g->areas_limit
+                        - g->players[owners[i] - 1].areas >= ADJOINING_FIELDS) {
+                    band->hit = true;
+                    atomic_store(band->stop, true);
+                    return NULL;
+                }
+                if (!gamma_band_push(band, f)) {
+                    band->failed = true;
+                    atomic_store(band->stop, true);
+                    return NULL;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+
+/** @brief Przejrzenie planszy przez wiele wątków.
+ * Plansza dzielona jest na pasy kolejnych wierszy, po jednym na wątek.
+ * Pas, dla którego nie udało się uruchomić wątku, przeglądany jest przez
+ * wątek wywołujący. Tablice kandydatów pasów należy zwolnić.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id            – identyfikator gracza,
+ * @param[in] stop_on_hit   – informacja o tym czy przeglądanie kończy się
+ *                            po znalezieniu pola, na którym na pewno można
+ *                            wykonać złoty ruch,
+ * @param[out] bands        – tablica opisów pasów,
+ * @param[in] threads       – liczba pasów.
+ * @return Wartość @p true, jeżeli wszystkie pasy zostały przejrzane
+ * w całości, @p false, jeżeli przeglądanie zostało przerwane.
+ */
+static bool gamma_bands_scan(const gamma_t *g, uint32_t id, bool stop_on_hit,
+                             gamma_band_t *bands, uint32_t threads) {
+    atomic_bool stop = false;
+    pthread_t workers[MAX_THREADS];
+    bool started[MAX_THREADS];
+    for (uint32_t i = 0; i < threads; ++i) {
+        bands[i] = (gamma_band_t) {
+                .g = g, .id = id, .stop_on_hit = stop_on_hit, .stop = &stop,
+                .first_row = (uint32_t) ((uint64_t) g->height * i / threads),
+                .last_row = (uint32_t) ((uint64_t) g->height * (i + 1)
+                                        / threads) };
     }
-    return gamma_get_player(g, player)->occupied_fields;
+    for (uint32_t i = 1; i < threads; ++i) {
+        started[i] = pthread_create(&workers[i], NULL, gamma_band_scan,
+                                    &bands[i]) == 0;
+    }
+    gamma_band_scan(&bands[0]);
+    for (uint32_t i = 1; i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(workers[i], NULL);
+        } else {
+            gamma_band_scan(&bands[i]);
+        }
+    }
+    return !atomic_load(&stop);
 }
 
 
-uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
-    player_t *player_info = gamma_get_player(g, player);
-    if (ISNULL(player_info)) {
-        return 0;
+/** @brief Odbudowanie listy kandydatów na złoty ruch gracza.
+ * Procedura przegląda całą planszę, dużą – wieloma wątkami, i wpisuje
+ * na listę pola innych graczy przylegające do pól gracza. Jeżeli zabraknie
+ * pamięci, lista pozostaje oznaczona jako niekompletna.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] player   – wskaźnik do informacji związanych z graczem.
+ */
+static void gamma_candidates_rebuild(gamma_t *g, player_t *player) {
+    uint32_t id = gamma_player_id(g, player);
+    player->candidates_lost = false;
+    uint32_t threads = gamma_scan_threads(g);
+    if (threads > 0) {
+        gamma_band_t bands[MAX_THREADS];
+        bool done = gamma_bands_scan(g, id, false, bands, threads);
+        for (uint32_t i = 0; i < threads; ++i) {
+            for (uint64_t j = 0; done && j < bands[i].size; ++j) {
+                gamma_candidate_push(g, player, bands[i].fields[j]);
+            }
+            free(bands[i].fields);
+        }
+        if (done) {
+            return;
+        }
     }
-    if (player_info->areas == g->areas_limit) {
-        return player_info->free_adjoining;
-    } else {
-        return (uint64_t) g->width * g->height - g->ocupied_fields;
+    for (uint32_t h = 0; h < g->height; ++h) {
+        for (uint32_t w = 0; w < g->width; ++w) {
+            field_t f = gamma_get_field(g, w, h);
+            uint32_t owner = field_owner(g->board, f);
+            if (owner != 0 && owner != id
+                    && field_count_adjoining_fields(g->board, f, id) > 0) {
+                gamma_candidate_push(g, player, f);
+            }
+        }
     }
 }
 
@@ -336,12 +2257,46 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player) {
          || g->ocupied_fields - p_info->occupied_fields == 0) {
         return false;
     }
-    for (uint32_t w = 0; w < g->width; ++w) {
-        for (uint32_t h = 0; h < g->height; ++h) {
-            field_t *f = gamma_get_field(g, w, h);
-            if (ISNULL(f)) {
-                return false;
+    if (p_info->areas < g->areas_limit) {
+        /* Każdy obszar ma pole, którego usunięcie go nie rozspójnia, więc
+         * złoty ruch na takim polu nie zwiększa liczby obszarów właściciela.
+         */
+        return true;
+    }
+    if (p_info->enemy_adjoining == 0) {
+        /* Gracz osiągnął limit obszarów i nie przylega do pól innych graczy.
+         */
+        return false;
+    }
+    if (p_info->candidates_lost) {
+        gamma_candidates_rebuild(g, p_info);
+    }
+    if (!p_info->candidates_lost) {
+        return gamma_golden_candidates(g, p_info);
+    }
+    uint32_t threads = gamma_scan_threads(g);
+    if (threads > 0) {
+        /* Wątki jedynie czytają planszę, a sprawdzenie rozspójnienia
+         * obszaru ją zmienia, więc pola, dla których jest ono potrzebne,
+         * sprawdzane są po zakończeniu wątków, w kolejności pól planszy. */
+        gamma_band_t bands[MAX_THREADS];
+        bool done = gamma_bands_scan(g, player, true, bands, threads);
+        bool result = false;
+        for (uint32_t i = 0; i < threads; ++i) {
+            result = result || bands[i].hit;
+            for (uint64_t j = 0; done && !result && j < bands[i].size; ++j) {
+                result = gamma_golden_move_possible(g, p_info,
+                                                    bands[i].fields[j]);
             }
+            free(bands[i].fields);
+        }
+        if (done || result) {
+            return result;
+        }
+    }
+    for (uint32_t h = 0; h < g->height; ++h) {
+        for (uint32_t w = 0; w < g->width; ++w) {
+            field_t f = gamma_get_field(g, w, h);
             if (gamma_golden_move_possible(g, p_info, f)) {
                 return true;
             }
@@ -351,52 +2306,653 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player) {
 }
 
 
+/** @brief Początkowe miejsce pola w tablicy mieszającej pól ruchów.
+ * @param[in] field         – identyfikator pola.
+ * @return Numer miejsca w tablicy o rozmiarze @ref BULK_SET.
+ */
+static inline uint32_t gamma_bulk_slot(field_t field) {
+    return (uint32_t) ((field * UINT64_C(0x9e3779b97f4a7c15)) >> 32)
+           & (BULK_SET - 1);
+}
+
+
+/** @brief Sprawdzenie czy w pobliżu pola jest pole wcześniejszego ruchu.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] set           – tablica mieszająca pól wcześniejszych ruchów,
+ * @param[in] x             – numer kolumny pola,
+ * @param[in] y             – numer wiersza pola.
+ * @return Wartość @p true, jeżeli pole jest odległe o co najwyżej dwa od
+ * któregoś z pól zapisanych w tablicy @p set.
+ */
+static bool gamma_bulk_near(const gamma_t *g, const field_t set[BULK_SET],
+                            uint32_t x, uint32_t y) {
+    for (int64_t dy = -2; dy <= 2; ++dy) {
+        int64_t reach = 2 - (dy < 0 ? -dy : dy);
+        for (int64_t dx = -reach; dx <= reach; ++dx) {
+            if (x + dx < 0 || x + dx >= g->width
+                    || y + dy < 0 || y + dy >= g->height) {
+                continue;
+            }
+            field_t field = field_at((uint32_t) (x + dx), (uint32_t) (y + dy));
+            uint32_t slot = gamma_bulk_slot(field);
+            while (set[slot] != FIELD_NONE) {
+                if (set[slot] == field) {
+                    return true;
+                }
+                slot = (slot + 1) & (BULK_SET - 1);
+            }
+        }
+    }
+    return false;
+}
+
+
+/** @brief Wybranie ruchów, które można wykonać równolegle.
+ * Równolegle można wykonać ruch na polu odległym o więcej niż dwa od pól
+ * wszystkich wcześniejszych ruchów; pozostałe ruchy są odkładane i zostaną
+ * wykonane kolejno, po ruchach wykonanych równolegle. Ruchy poza planszą
+ * są nielegalne.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves         – tablica ruchów,
+ * @param[in] count         – liczba ruchów, nie większa od @ref BULK_WINDOW,
+ * @param[out] claims       – tablica wyników ruchów, w której zostaną
+ *                            oznaczone ruchy do wykonania równolegle,
+ * @param[in, out] set      – pusta tablica mieszająca (wypełniona
+ *                            @ref FIELD_NONE); po wywołaniu znów pusta,
+ * @param[out] slots        – tablica pomocnicza na numery zajętych miejsc
+ *                            tablicy mieszającej.
+ * @return Liczba ruchów do wykonania równolegle.
+ */
+static size_t gamma_bulk_mark(const gamma_t *g, const gamma_play_t *moves,
+                              size_t count, gamma_claim_t *claims,
+                              field_t set[BULK_SET],
+                              uint32_t slots[BULK_WINDOW]) {
+    size_t pending = 0, used = 0;
+    for (size_t i = 0; i < count; ++i) {
+        field_t field = gamma_get_field(g, moves[i].x, moves[i].y);
+        if (field == FIELD_NONE) {
+            claims[i].state = CLAIM_FAILED;
+            continue;
+        }
+        if (gamma_bulk_near(g, set, moves[i].x, moves[i].y)) {
+            claims[i].state = CLAIM_DEFERRED;
+        } else {
+            claims[i].state = CLAIM_PENDING;
+            pending++;
+        }
+        uint32_t slot = gamma_bulk_slot(field);
+        while (set[slot] != FIELD_NONE) {
+            slot = (slot + 1) & (BULK_SET - 1);
+        }
+        set[slot] = field;
+        slots[used++] = slot;
+    }
+    for (size_t i = 0; i < used; ++i) {
+        set[slots[i]] = FIELD_NONE;
+    }
+    return pending;
+}
+
+
+/** @brief Zajęcie pola ruchem wykonywanym równolegle.
+ * Pole zajmowane jest jedynie wtedy, gdy przylega do dokładnie jednego
+ * obszaru gracza: taki ruch jest zawsze legalny i nie zmienia liczby
+ * obszarów gracza. Pozostałe legalne ruchy są odkładane. Funkcja czyta
+ * jedynie pola odległe od pola ruchu o co najwyżej dwa i zapisuje samo pole.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] move          – ruch,
+ * @param[out] claim        – wynik ruchu.
+ */
+static void gamma_claim_take(gamma_t *g, const gamma_play_t *move,
+                             gamma_claim_t *claim) {
+    field_t field = gamma_get_field(g, move->x, move->y);
+    if (field == FIELD_NONE || !test_player(g, move->player)
+            || field_owner(g->board, field) != 0) {
+        claim->state = CLAIM_FAILED;
+        return;
+    }
+    if (field_count_adjoining_areas(g->board, field, move->player) != 1) {
+        claim->state = CLAIM_DEFERRED;
+        return;
+    }
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    claim->fresh = 0;
+    claim->contact = 0;
+    for (uint32_t i = 0; i < ADJOINING_FIELDS; ++i) {
+        claim->owners[i] = i < size ? field_owner(g->board, adjoining[i]) : 0;
+        if (i >= size || claim->owners[i] == move->player
+                || field_count_adjoining_fields(g->board, adjoining[i],
+                                                move->player) != 0) {
+            continue;
+        }
+        if (claim->owners[i] == 0) {
+            claim->fresh++;
+        } else {
+            claim->contact |= (uint32_t) 1 << i;
+        }
+    }
+    claim->area = field_claim(g->board, field, move->player);
+    claim->state = CLAIM_TAKEN;
+}
+
+
+/** @brief Wykonanie ruchów @ref gamma_move_bulk w pasie wierszy planszy.
+ * @param[in, out] arg      – wskaźnik na opis pasa.
+ * @return Wartość `NULL`.
+ */
+static void *gamma_claim_band_run(void *arg) {
+    gamma_claim_band_t *band = arg;
+    for (size_t i = 0; i < band->count; ++i) {
+        const gamma_play_t *move = &band->moves[i];
+        /* Stan ruchu z innego pasa zmienia inny wątek. */
+        if (move->y >= band->first_row && move->y < band->last_row
+                && band->claims[i].state == CLAIM_PENDING) {
+            gamma_claim_take(band->g, move, &band->claims[i]);
+        }
+    }
+    return NULL;
+}
+
+
+/** @brief Uzupełnienie stanu gry po równoległym zajęciu pola.
+ * Wykonuje te części @ref gamma_take_field, które zmieniają wspólne dla
+ * wątków liczniki i listy, na podstawie zapamiętanego sąsiedztwa pola.
+ * Na listy kandydatów dopisywane są jedynie nowe pary gracza i pola.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] move          – ruch,
+ * @param[in] claim         – wynik ruchu.
+ */
+static void gamma_claim_apply(gamma_t *g, const gamma_play_t *move,
+                              const gamma_claim_t *claim) {
+    field_t field = field_at(move->x, move->y);
+    player_t *player = &g->players[move->player - 1];
+    field_t adjoining[ADJOINING_FIELDS];
+    uint32_t size = field_adjoining(g->board, field, adjoining);
+    field_claim_finish(g->board, claim->area);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t owner = claim->owners[i];
+        if (owner == 0) {
+            if (!ISNULL(g->frontiers)) {
+                gamma_frontier_push(g, move->player, adjoining[i]);
+            }
+            continue;
+        }
+        bool repeated = false;
+        for (uint32_t j = 0; j < i; ++j) {
+            repeated |= claim->owners[j] == owner;
+        }
+        player_t *current = &g->players[owner - 1];
+        current->free_adjoining -= !repeated;
+        if (owner == move->player) {
+            continue;
+        }
+        player->enemy_adjoining += claim->contact >> i & 1;
+        gamma_candidate_push(g, player, adjoining[i]);
+        if (!repeated) {
+            current->enemy_adjoining++;
+            gamma_candidate_push(g, current, field);
+        }
+    }
+    player->free_adjoining += claim->fresh;
+    gamma_dirty_push(g, field);
+    gamma_taken_update(g, field, true);
+    g->version++;
+    g->ocupied_fields++;
+    player->occupied_fields++;
+}
+
+
+/** @brief Równoległe wykonanie ciągu ruchów oznaczonych przez
+ * @ref gamma_bulk_mark.
+ * Wątki zajmują pola w swoich pasach wierszy, po czym wątek wywołujący
+ * uzupełnia liczniki i kolejno wykonuje odłożone ruchy. Ruch wykonany
+ * równolegle jest odległy o więcej niż dwa od wcześniejszych ruchów, a nie
+ * zmienia liczby obszarów graczy, więc nie wpływa na wcześniejsze odłożone
+ * ruchy i wynik jest taki sam jak przy wykonaniu kolejnym; łączenie
+ * obszarów przez odłożony ruch zmienia jedynie identyfikatory obszarów.
+ * @param[in, out] g        – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves         – tablica ruchów,
+ * @param[in] count         – liczba ruchów,
+ * @param[out] results      – tablica wyników ruchów lub `NULL`,
+ * @param[in, out] claims   – tablica wyników ruchów,
+ * @param[in] threads       – liczba wątków.
+ * @return Liczba wykonanych ruchów.
+ */
+static size_t gamma_bulk_apply(gamma_t *g, const gamma_play_t *moves,
+                               size_t count, bool *results,
+                               gamma_claim_t *claims, uint32_t threads) {
+    gamma_claim_band_t bands[MAX_THREADS];
+    pthread_t workers[MAX_THREADS];
+    bool started[MAX_THREADS];
+    for (uint32_t i = 0; i < threads; ++i) {
+        bands[i] = (gamma_claim_band_t) {
+                .g = g, .moves = moves, .claims = claims, .count = count,
+                .first_row = (uint32_t) ((uint64_t) g->height * i / threads),
+                .last_row = (uint32_t) ((uint64_t) g->height * (i + 1)
+                                        / threads) };
+    }
+    gamma_write_begin(g);
+    for (uint32_t i = 1; i < threads; ++i) {
+        started[i] = pthread_create(&workers[i], NULL, gamma_claim_band_run,
+                                    &bands[i]) == 0;
+    }
+    gamma_claim_band_run(&bands[0]);
+    for (uint32_t i = 1; i < threads; ++i) {
+        if (started[i]) {
+            pthread_join(workers[i], NULL);
+        } else {
+            gamma_claim_band_run(&bands[i]);
+        }
+    }
+    size_t done = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (claims[i].state == CLAIM_TAKEN) {
+            gamma_claim_apply(g, &moves[i], &claims[i]);
+            done++;
+        }
+    }
+    gamma_write_end(g);
+    for (size_t i = 0; i < count; ++i) {
+        bool result = claims[i].state == CLAIM_TAKEN;
+        if (claims[i].state == CLAIM_DEFERRED) {
+            result = gamma_move(g, moves[i].player, moves[i].x, moves[i].y);
+            done += result;
+        }
+        if (!ISNULL(results)) {
+            results[i] = result;
+        }
+    }
+    return done;
+}
+
+
+size_t gamma_move_bulk(gamma_t *g, const gamma_play_t *moves, size_t count,
+                       bool *results) {
+    if (ISNULL(g) || ISNULL(moves)) {
+        return 0;
+    }
+    uint32_t threads = 0;
+    if (!g->read_only && !g->journal && count >= BULK_MIN
+            && field_board_storage(g->board) == BOARD_STORAGE_DENSE) {
+        threads = gamma_scan_threads(g);
+    }
+    gamma_claim_t *claims = NULL;
+    field_t *set = NULL;
+    uint32_t *slots = NULL;
+    if (threads > 1) {
+        claims = malloc(BULK_WINDOW * sizeof(gamma_claim_t));
+        set = malloc(BULK_SET * sizeof(field_t));
+        slots = malloc(BULK_WINDOW * sizeof(uint32_t));
+        if (ISNULL(claims) || ISNULL(set) || ISNULL(slots)) {
+            free(claims);
+            claims = NULL;
+        } else {
+            for (size_t i = 0; i < BULK_SET; ++i) {
+                set[i] = FIELD_NONE;
+            }
+        }
+    }
+    size_t done = 0;
+    for (size_t first = 0; first < count;) {
+        size_t size = count - first < BULK_WINDOW ? count - first
+                                                  : BULK_WINDOW;
+        if (!ISNULL(claims)
+                && gamma_bulk_mark(g, moves + first, size, claims, set,
+                                   slots) >= BULK_MIN
+                && field_reserve_claims(g->board, size)) {
+            done += gamma_bulk_apply(g, moves + first, size,
+                                     ISNULL(results) ? NULL : results + first,
+                                     claims, threads);
+        } else {
+            for (size_t i = first; i < first + size; ++i) {
+                bool result = gamma_move(g, moves[i].player, moves[i].x,
+                                         moves[i].y);
+                done += result;
+                if (!ISNULL(results)) {
+                    results[i] = result;
+                }
+            }
+        }
+        first += size;
+    }
+    free(claims);
+    free(set);
+    free(slots);
+    return done;
+}
+
+
 char *gamma_board(gamma_t *g) {
     if (ISNULL(g)) {
         return NULL;
     }
-    int max_len = uint64_length((uint64_t) g->no_players);
-    size_t size = max_len * g->width * g->height + g->height + 1;
-    char *result = calloc(sizeof(char), size);
+    uint64_t row_size = (uint64_t) uint64_length((uint64_t) g->no_players)
+                        * g->width + 1;
+    if (row_size > (SIZE_MAX - 1) / g->height) {
+        return NULL;
+    }
+    size_t size = row_size * g->height + 1;
+    char *result = malloc(size);
     if (ISNULL(result)) {
         return NULL;
     }
     if (gamma_board_buffer(g, result, size)) {
         return result;
     } else {
+        free(result);
         return NULL;
     }
 }
 
 
-bool gamma_board_buffer(gamma_t *g, char *buffer, size_t size) {
-    if (ISNULL(g) || ISNULL(buffer)) {
-        return false;
-    }
+/** @brief Zapisanie napisu opisującego stan planszy do bufora.
+ * W przeciwieństwie do @ref gamma_board_buffer funkcja nie zmienia stanu
+ * gry, więc może być wywoływana przez czytelników z innych wątków.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] buffer       – bufor do którego ma zostać zapisana plansza,
+ * @param[in] size          – rozmiar bufora.
+ * @return Wartość @p true jeżeli udało się umieścić napis w buforze,
+ * wartość @p false w przeciwnym wypadku.
+ */
+static bool gamma_board_render(const gamma_t *g, char *buffer,
+                               size_t size) {
     /** Jeżeli liczba graczy jest większa od 9 to identyfikatory zapisywane
      * są w blokach o długości ilości cyfr w liczbie graczy.
      * Przestrzeń niewykorzystywana w ramach bloku wypełniana jest spacjami.
      */
-    size_t current_size = 0;
-    char *current = buffer;
     uint32_t id_len = uint64_length((uint64_t) g->no_players);
+    uint64_t row_size = (uint64_t) id_len * g->width + 1;
+    if (size == 0 || row_size * g->height > size) {
+        return false;
+    }
+    /** Właściciele pól odczytywani są odcinkami wierszy do tablicy
+     * pomocniczej i wypisywani jednym wywołaniem dla całego odcinka.
+     */
+    uint32_t owners[BOARD_CHUNK];
+    char *current = buffer;
     for (uint32_t i = g->height; i > 0; --i) {
-        for (uint32_t j = 0; j < g->width; ++j) {
-            field_t *f = gamma_get_field(g, j, i - 1);
-            int k = player_write(current, size, field_owner(f), id_len);
-            current += k;
-            current_size += k;
+        for (uint32_t j = 0; j < g->width; j += BOARD_CHUNK) {
+            uint32_t count = g->width - j < BOARD_CHUNK ? g->width - j
+                                                        : BOARD_CHUNK;
+            field_owners(g->board, j, i - 1, count, owners);
+            current += players_write(current, owners, count, id_len);
         }
-        current[0] = '\n';
-        current++;
-        current_size++;
+        *current++ = '\n';
+    }
+    if ((size_t) (current - buffer) < size) {
+        *current = '\0';
     }
     buffer[size - 1] = '\0';
-    if (size >= current_size) {
+    return true;
+}
+
+
+bool gamma_board_buffer(gamma_t *g, char *buffer, size_t size) {
+    if (ISNULL(g) || ISNULL(buffer) || !gamma_board_render(g, buffer, size)) {
+        return false;
+    }
+    g->rendered = true;
+    g->dirty_lost = false;
+    g->dirty_size = 0;
+    return true;
+}
+
+
+/** @brief Rozpoczęcie odczytu stanu gry z innego wątku.
+ * Jeżeli właśnie trwa zmiana stanu gry, funkcja oddaje procesor do jej
+ * zakończenia.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość licznika sekwencji, którą należy przekazać do
+ * @ref gamma_read_retry.
+ */
+static uint64_t gamma_read_begin(const gamma_t *g) {
+    uint64_t sequence;
+    while ((sequence = atomic_load_explicit(&g->sequence,
+                                            memory_order_acquire)) % 2 != 0) {
+        sched_yield();
+    }
+    return sequence;
+}
+
+
+/** @brief Sprawdzenie czy odczyt stanu gry należy powtórzyć.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] sequence      – wartość zwrócona przez @ref gamma_read_begin.
+ * @return Wartość @p true, jeżeli w trakcie odczytu stan gry się zmienił.
+ */
+static bool gamma_read_retry(const gamma_t *g, uint64_t sequence) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&g->sequence, memory_order_relaxed)
+           != sequence;
+}
+
+
+uint64_t gamma_read_busy_fields(const gamma_t *g, uint32_t player) {
+    if (ISNULL(g) || !test_player(g, player)) {
+        return 0;
+    }
+    const player_t *player_info = gamma_get_player(g, player);
+    uint64_t sequence, result;
+    do {
+        sequence = gamma_read_begin(g);
+        result = player_info->occupied_fields;
+    } while (gamma_read_retry(g, sequence));
+    return result;
+}
+
+
+uint64_t gamma_read_free_fields(const gamma_t *g, uint32_t player) {
+    if (ISNULL(g) || !test_player(g, player)) {
+        return 0;
+    }
+    const player_t *player_info = gamma_get_player(g, player);
+    uint64_t sequence, result;
+    do {
+        sequence = gamma_read_begin(g);
+        if (player_info->areas == g->areas_limit) {
+            result = player_info->free_adjoining;
+        } else {
+            result = (uint64_t) g->width * g->height - g->ocupied_fields;
+        }
+    } while (gamma_read_retry(g, sequence));
+    return result;
+}
+
+
+bool gamma_read_board_buffer(const gamma_t *g, char *buffer, size_t size) {
+    if (ISNULL(g) || ISNULL(buffer)) {
+        return false;
+    }
+    uint64_t sequence;
+    bool result;
+    do {
+        sequence = gamma_read_begin(g);
+        result = gamma_board_render(g, buffer, size);
+    } while (gamma_read_retry(g, sequence));
+    return result;
+}
+
+
+bool gamma_board_update(gamma_t *g, char *buffer, size_t size) {
+    if (ISNULL(g) || ISNULL(buffer)) {
+        return false;
+    }
+    if (!g->rendered || g->dirty_lost) {
+        return gamma_board_buffer(g, buffer, size);
+    }
+    uint32_t id_len = uint64_length((uint64_t) g->no_players);
+    uint64_t row_size = (uint64_t) id_len * g->width + 1;
+    if (size == 0 || row_size * g->height > size) {
+        return false;
+    }
+    /** Pole zmienione kilka razy poprawiane jest kilka razy – zawsze zgodnie
+     * z aktualnym właścicielem.
+     */
+    for (uint64_t i = 0; i < g->dirty_size; ++i) {
+        field_t f = g->dirty[i];
+        uint32_t owner = field_owner(g->board, f);
+        players_write(buffer + (g->height - 1 - field_row(f)) * row_size
+                      + (uint64_t) field_column(f) * id_len, &owner, 1,
+                      id_len);
+    }
+    g->dirty_size = 0;
+    return true;
+}
+
+
+bool gamma_view(const gamma_t *g, gamma_view_t *view) {
+    if (ISNULL(g) || ISNULL(view)) {
+        return false;
+    }
+    uint32_t owner_size;
+    uint64_t stride;
+    const void *owners = field_owners_array(g->board, &owner_size, &stride);
+    if (ISNULL(owners)) {
+        return false;
+    }
+    *view = (gamma_view_t) { .owners = owners, .owner_size = owner_size,
+                             .row_stride = stride, .width = g->width,
+                             .height = g->height, .version = g->version };
+    return true;
+}
+
+
+uint64_t gamma_version(const gamma_t *g) {
+    return !ISNULL(g) ? g->version : 0;
+}
+
+
+bool gamma_gather(const gamma_t *g, const gamma_coords_t *coords, size_t count,
+                  uint32_t *owners) {
+    if (ISNULL(g) || ISNULL(coords) || ISNULL(owners)) {
+        return false;
+    }
+    /** Współrzędne zamieniane są na identyfikatory pól porcjami, a pola
+     * o niepoprawnych współrzędnych zastępowane polem (0, 0) i zerowane.
+     */
+    bool valid = true;
+    field_t fields[GATHER_CHUNK];
+    for (size_t i = 0; i < count; i += GATHER_CHUNK) {
+        size_t chunk = count - i < GATHER_CHUNK ? count - i : GATHER_CHUNK;
+        for (size_t j = 0; j < chunk; ++j) {
+            fields[j] = gamma_get_field(g, coords[i + j].x, coords[i + j].y);
+            if (fields[j] == FIELD_NONE) {
+                fields[j] = field_at(0, 0);
+            }
+        }
+        field_gather(g->board, fields, chunk, owners + i);
+        for (size_t j = 0; j < chunk; ++j) {
+            if (!test_field(g, coords[i + j].x, coords[i + j].y)) {
+                owners[i + j] = 0;
+                valid = false;
+            }
+        }
+    }
+    return valid;
+}
+
+
+/** Funkcja zapisująca porcję tekstu planszy.
+ * Zwraca @p true jeżeli udało się zapisać cały tekst.
+ */
+typedef bool (*gamma_sink_t)(void *context, const char *text, size_t size);
+
+
+/** @brief Wypisanie prostokąta planszy porcjami.
+ * Każdy wiersz prostokąta tworzony jest odcinkami po @ref BOARD_CHUNK pól
+ * w buforze na stosie i przekazywany funkcji @p sink.
+ * @param[in] g             – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x             – numer pierwszej kolumny,
+ * @param[in] y             – numer pierwszego wiersza,
+ * @param[in] width         – liczba kolumn,
+ * @param[in] height        – liczba wierszy,
+ * @param[in] sink          – funkcja zapisująca tekst,
+ * @param[in] context       – argument funkcji @p sink.
+ * @return Wartość @p true jeżeli udało się wypisać prostokąt, @p false jeżeli
+ * wykracza on poza planszę lub zapis się nie powiódł.
+ */
+static bool gamma_board_stream(gamma_t *g, uint32_t x, uint32_t y,
+                               uint32_t width, uint32_t height,
+                               gamma_sink_t sink, void *context) {
+    if (ISNULL(g) || x > g->width || width > g->width - x
+            || y > g->height || height > g->height - y) {
+        return false;
+    }
+    if (width == 0) {
         return true;
-    } else {
+    }
+    uint32_t id_len = uint64_length((uint64_t) g->no_players);
+    uint32_t owners[BOARD_CHUNK];
+    /* Najdłuższy identyfikator gracza ma 10 cyfr. */
+    char text[BOARD_CHUNK * 10 + 1];
+    for (uint32_t i = y + height; i > y; --i) {
+        for (uint32_t j = 0; j < width; j += BOARD_CHUNK) {
+            uint32_t count = width - j < BOARD_CHUNK ? width - j : BOARD_CHUNK;
+            field_owners(g->board, x + j, i - 1, count, owners);
+            size_t size = players_write(text, owners, count, id_len);
+            if (j + count == width) {
+                text[size++] = '\n';
+            }
+            if (!sink(context, text, size)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/** @brief Zapis tekstu planszy do strumienia.
+ * @param[in] context       – strumień (`FILE *`),
+ * @param[in] text          – tekst,
+ * @param[in] size          – długość tekstu.
+ * @return Wartość @p true jeżeli udało się zapisać cały tekst.
+ */
+static bool gamma_sink_stream(void *context, const char *text, size_t size) {
+    return fwrite(text, sizeof(char), size, context) == size;
+}
+
+
+/** @brief Zapis tekstu planszy do deskryptora pliku.
+ * @param[in] context       – wskaźnik na deskryptor pliku,
+ * @param[in] text          – tekst,
+ * @param[in] size          – długość tekstu.
+ * @return Wartość @p true jeżeli udało się zapisać cały tekst.
+ */
+static bool gamma_sink_fd(void *context, const char *text, size_t size) {
+    int fd = *(const int *) context;
+    while (size > 0) {
+        ssize_t written = write(fd, text, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        text += written;
+        size -= (size_t) written;
+    }
+    return true;
+}
+
+
+bool gamma_board_fwrite(gamma_t *g, FILE *stream, uint32_t x, uint32_t y,
+                        uint32_t width, uint32_t height) {
+    if (ISNULL(stream)) {
+        return false;
+    }
+    return gamma_board_stream(g, x, y, width, height, gamma_sink_stream,
+                              stream);
+}
+
+
+bool gamma_board_write(gamma_t *g, int fd, uint32_t x, uint32_t y,
+                       uint32_t width, uint32_t height) {
+    if (fd < 0) {
         return false;
     }
+    return gamma_board_stream(g, x, y, width, height, gamma_sink_fd, &fd);
 }
 
 
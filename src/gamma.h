@@ -13,6 +13,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 
 /** Liczba parametrów funkcji @ref gamma_new.
@@ -25,6 +26,99 @@
 typedef struct gamma gamma_t;
 
 
+/** Pula nieużywanych silników gry.
+ */
+typedef struct gamma_pool gamma_pool_t;
+
+
+/** Sposób przechowywania planszy.
+ */
+typedef enum gamma_storage {
+    GAMMA_STORAGE_AUTO, /**< Sposób dobierany do rozmiaru planszy. */
+    GAMMA_STORAGE_DENSE, /**< Pamięć na wszystkie pola przydzielana od razu. */
+    GAMMA_STORAGE_SPARSE, /**< Pamięć przydzielana fragmentami planszy,
+                           * dopiero przy zajęciu w nich pierwszego pola. */
+    GAMMA_STORAGE_BITBOARD /**< Pamięć przydzielana od razu, z bitmapą pól
+                            * każdego gracza. Dla plansz o bokach do 64 pól
+                            * i co najwyżej 64 graczy (dla nich jest to
+                            * sposób domyślny). */
+} gamma_storage_t;
+
+
+/** Układ pól planszy w pamięci.
+ */
+typedef enum gamma_layout {
+    GAMMA_LAYOUT_ROWS, /**< Pola ułożone wierszami. */
+    GAMMA_LAYOUT_SQUARES /**< Pola ułożone w kwadratach 8 na 8, dzięki czemu
+                          * sąsiedzi pola z sąsiednich wierszy leżą zwykle
+                          * blisko niego w pamięci. Przyspiesza ruchy
+                          * na szerokich planszach. */
+} gamma_layout_t;
+
+
+/** Funkcje przydzielające pamięć grze, używane przez @ref gamma_new_ext.
+ */
+typedef struct gamma_allocator {
+    /** Przydziela wyzerowany blok pamięci o rozmiarze `size` bajtów,
+     * wyrównany do `alignment` bajtów (potęgi dwójki), lub zwraca `NULL`. */
+    void *(*alloc)(void *context, size_t size, size_t alignment);
+    /** Zwalnia blok `memory` o rozmiarze `size` przydzielony przez `alloc`. */
+    void (*free)(void *context, void *memory, size_t size);
+    void *context; /**< Argument przekazywany obu funkcjom. */
+} gamma_allocator_t;
+
+
+/** Dodatkowe opcje tworzenia gry, używane przez @ref gamma_new_ext.
+ * Wyzerowana struktura odpowiada ustawieniom domyślnym.
+ */
+typedef struct gamma_options {
+    gamma_storage_t storage; /**< Sposób przechowywania planszy. */
+    gamma_layout_t layout; /**< Układ pól planszy w pamięci. */
+    const char *path; /**< Ścieżka do pliku, w którym przechowywany będzie
+                       * stan gry, lub `NULL`. Plansza w pliku ma układ
+                       * planszy gęstej. */
+    const gamma_allocator_t *allocator; /**< Funkcje przydzielające pamięć
+                                         * lub `NULL` dla domyślnych. */
+    uint32_t threads; /**< Liczba wątków przeglądających dużą planszę
+                       * (na przykład w @ref gamma_golden_possible) lub `0`
+                       * dla liczby dostępnych procesorów. */
+} gamma_options_t;
+
+
+/** Widok tablicy właścicieli pól planszy, tylko do odczytu.
+ * Właściciel pola (`x`, `y`) to liczba bez znaku o rozmiarze
+ * @ref owner_size bajtów pod adresem
+ * `owners + (y * row_stride + x) * owner_size`; `0` oznacza wolne pole.
+ * Wiersz `0` to dolny wiersz planszy (ostatni w @ref gamma_board).
+ */
+typedef struct gamma_view {
+    const void *owners; /**< Początek tablicy właścicieli pól. */
+    uint32_t owner_size; /**< Rozmiar identyfikatora właściciela (1, 2 lub 4
+                          * bajty). */
+    uint64_t row_stride; /**< Odległość kolejnych wierszy w elementach. */
+    uint32_t width; /**< Szerokość planszy. */
+    uint32_t height; /**< Wysokość planszy. */
+    uint64_t version; /**< Numer wersji planszy w chwili utworzenia widoku. */
+} gamma_view_t;
+
+
+/** Współrzędne pola planszy.
+ */
+typedef struct gamma_coords {
+    uint32_t x; /**< Numer kolumny. */
+    uint32_t y; /**< Numer wiersza. */
+} gamma_coords_t;
+
+
+/** Zwykły ruch gracza wykonywany przez @ref gamma_move_bulk.
+ */
+typedef struct gamma_play {
+    uint32_t player; /**< Numer gracza. */
+    uint32_t x; /**< Numer kolumny. */
+    uint32_t y; /**< Numer wiersza. */
+} gamma_play_t;
+
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -40,9 +134,167 @@ gamma_t* gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
 
+/** @brief Tworzy strukturę przechowującą stan gry z dodatkowymi opcjami.
+ * Działa jak @ref gamma_new, ale pozwala wybrać sposób przechowywania planszy.
+ * Plansza rzadka zajmuje pamięć proporcjonalną do zajętej części planszy,
+ * a nie do jej rozmiaru, i pozwala tworzyć gry na bardzo dużych planszach.
+ * Plansza w pliku może być większa niż pamięć operacyjna i pozwala wrócić
+ * do gry funkcją @ref gamma_open.
+ *
+ * Struktura gry, tablica graczy i plansza (bez fragmentów planszy rzadkiej)
+ * zajmują jeden blok pamięci, przydzielany jednym wywołaniem
+ * gamma_allocator::alloc i zwalniany przez @ref gamma_delete jednym
+ * wywołaniem gamma_allocator::free. Bloki od 2 MiB wyrównane są do rozmiaru
+ * dużej strony. Pamięć potrzebna w trakcie gry (np. gdy rosną tablice
+ * pomocnicze) przydzielana jest standardowo. Gra przechowywana w pliku zajmuje
+ * w bloku jedynie strukturę gry.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia,
+ * @param[in] options – wskaźnik na opcje lub `NULL` dla opcji domyślnych.
+ * @return Wskaźnik na utworzoną strukturę lub `NULL`, gdy nie udało się
+ * zaalokować pamięci lub któryś z parametrów jest niepoprawny.
+ */
+gamma_t* gamma_new_ext(uint32_t width, uint32_t height, uint32_t players,
+                       uint32_t areas, const gamma_options_t *options);
+
+
+/** @brief Otwiera grę zapisaną w pliku.
+ * Odtwarza stan gry utworzonej przez @ref gamma_new_ext z opcją
+ * gamma_options::path, zamkniętej funkcją @ref gamma_delete. Plik jest
+ * mapowany do pamięci, więc otwarcie nie wymaga wczytywania planszy,
+ * a dalsze ruchy zapisywane są w tym samym pliku.
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wskaźnik na strukturę przechowującą stan gry lub `NULL`, gdy nie
+ * udało się otworzyć pliku lub nie zawiera on poprawnie zamkniętej gry.
+ */
+gamma_t* gamma_open(const char *path);
+
+
+/** @brief Otwiera grę zapisaną w pliku tylko do odczytu.
+ * Działa jak @ref gamma_open, ale nie zmienia pliku: plik mapowany jest
+ * prywatnie, więc z dysku czytane są tylko strony planszy, do których
+ * sięgają zapytania, a czas otwarcia nie zależy od rozmiaru planszy.
+ * Ruchy w tak otwartej grze kończą się niepowodzeniem. Ten sam plik może być
+ * jednocześnie otwarty tylko do odczytu wielokrotnie, ale nie może być w tym
+ * czasie zmieniany. Migawkę zapisaną funkcją @ref gamma_save można zamienić
+ * na taki plik, wczytując ją funkcją @ref gamma_load z opcją
+ * gamma_options::path.
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wskaźnik na strukturę przechowującą stan gry lub `NULL`, gdy nie
+ * udało się otworzyć pliku lub nie zawiera on poprawnie zamkniętej gry.
+ */
+gamma_t* gamma_open_readonly(const char *path);
+
+
+/** @brief Tworzy kopię gry.
+ * Kopia jest niezależną grą w pamięci, w tym samym stanie co @p g (także
+ * gdy @p g jest przechowywana w pliku lub otwarta tylko do odczytu), z tymi
+ * samymi funkcjami przydzielającymi pamięć. Na planszy rzadkiej fragmenty
+ * planszy są współdzielone przez obie gry i kopiowane dopiero przed pierwszą
+ * zmianą, więc kopia kosztuje czas i pamięć proporcjonalne do liczby
+ * fragmentów i obszarów, a nie pól, a dalej – do liczby zmienionych
+ * fragmentów. Na pozostałych planszach kopiowana jest cała plansza.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wskaźnik na strukturę kopii lub `NULL`, gdy nie udało się
+ * zaalokować pamięci lub @p g ma wartość `NULL`.
+ */
+gamma_t* gamma_clone(gamma_t *g);
+
+
+/** @brief Czyści grę.
+ * Przywraca stan gry @p g po utworzeniu (puste pola, liczniki graczy,
+ * pusty dziennik ruchów), nie zmieniając wymiarów planszy, liczby graczy
+ * ani limitu obszarów. Pamięć gry jest używana ponownie, więc kolejna
+ * rozgrywka na planszy tych samych wymiarów nie przydziela jej od nowa.
+ * Koszt jest proporcjonalny do rozmiaru tablic planszy (w trybie rzadkim –
+ * do liczby utworzonych fragmentów).
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true jeżeli gra została wyczyszczona, @p false jeżeli
+ * wskaźnik ma wartość `NULL` lub gra jest otwarta tylko do odczytu.
+ */
+bool gamma_reset(gamma_t *g);
+
+
+/** @brief Tworzy pulę nieużywanych silników gry.
+ * Pula przechowuje wyczyszczone silniki oddane funkcją
+ * @ref gamma_pool_put i wydaje je funkcją @ref gamma_pool_get dla plansz
+ * o tych samych wymiarach i liczbie graczy. Pula nie jest zabezpieczona
+ * przed jednoczesnym użyciem przez wiele wątków.
+ * @param[in] capacity – największa liczba przechowywanych silników.
+ * @return Wskaźnik na pulę lub `NULL`, gdy nie udało się zaalokować pamięci
+ * lub @p capacity jest zerem.
+ */
+gamma_pool_t* gamma_pool_new(size_t capacity);
+
+
+/** @brief Usuwa pulę silników gry.
+ * Usuwa pulę wraz z przechowywanymi silnikami. Nic nie robi, jeśli wskaźnik
+ * ma wartość `NULL`.
+ * @param[in] pool    – wskaźnik na pulę.
+ */
+void gamma_pool_delete(gamma_pool_t *pool);
+
+
+/** @brief Wydaje silnik gry z puli.
+ * Zwraca przechowywany silnik o podanych wymiarach i liczbie graczy,
+ * z ustawionym limitem obszarów @p areas, a gdy takiego nie ma – tworzy
+ * nowy funkcją @ref gamma_new. Wydany silnik należy do wywołującego.
+ * @param[in,out] pool – wskaźnik na pulę,
+ * @param[in] width    – szerokość planszy,
+ * @param[in] height   – wysokość planszy,
+ * @param[in] players  – liczba graczy,
+ * @param[in] areas    – maksymalna liczba obszarów gracza.
+ * @return Wskaźnik na pustą grę lub `NULL`, gdy któryś z parametrów jest
+ * niepoprawny lub nie udało się zaalokować pamięci.
+ */
+gamma_t* gamma_pool_get(gamma_pool_t *pool, uint32_t width, uint32_t height,
+                        uint32_t players, uint32_t areas);
+
+
+/** @brief Oddaje silnik gry do puli.
+ * Silnik jest czyszczony funkcją @ref gamma_reset (z wyłączeniem dziennika
+ * ruchów) i przechowywany do ponownego wydania. Jeżeli pula jest pełna lub
+ * silnika nie można wyczyścić, zostaje on usunięty. Nic nie robi, jeśli
+ * @p g ma wartość `NULL`.
+ * @param[in,out] pool – wskaźnik na pulę,
+ * @param[in] g        – wskaźnik na oddawaną grę.
+ */
+void gamma_pool_put(gamma_pool_t *pool, gamma_t *g);
+
+
+/** @brief Zapisuje migawkę stanu gry.
+ * Zapisuje do strumienia zwarty, binarny opis gry: wymiary planszy, limit
+ * obszarów, liczniki graczy (w tym informacje o wykonaniu złotego ruchu)
+ * i właścicieli pól. Odcinki wierszy złożone z samych wolnych pól zajmują
+ * jeden bajt. Migawka jest w formacie bieżącej architektury i zawiera numer
+ * wersji formatu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] stream  – strumień wyjściowy.
+ * @return Wartość @p true jeżeli udało się zapisać migawkę, @p false
+ * w przeciwnym wypadku lub gdy parametry są niepoprawne.
+ */
+bool gamma_save(gamma_t *g, FILE *stream);
+
+
+/** @brief Odtwarza grę z migawki.
+ * Tworzy grę (jak @ref gamma_new_ext z podanymi opcjami) w stanie zapisanym
+ * funkcją @ref gamma_save. Obszary graczy odtwarzane są z właścicieli pól,
+ * bez ponownego wykonywania ruchów.
+ * @param[in] stream  – strumień wejściowy,
+ * @param[in] options – wskaźnik na opcje tworzenia gry lub `NULL`.
+ * @return Wskaźnik na strukturę przechowującą stan gry lub `NULL`, gdy nie
+ * udało się zaalokować pamięci, wczytać migawki lub jest ona niepoprawna.
+ */
+gamma_t* gamma_load(FILE *stream, const gamma_options_t *options);
+
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
- * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
+ * Nic nie robi, jeśli wskaźnik ten ma wartość NULL. Gra przechowywana
+ * w pliku zostaje w nim zapisana.
  * @param[in] g       – wskaźnik na usuwaną strukturę.
  */
 void gamma_delete(gamma_t *g);
@@ -63,6 +315,27 @@ void gamma_delete(gamma_t *g);
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
 
+/** @brief Wykonuje kolejno ciąg zwykłych ruchów.
+ * Wynik jest taki sam jak przy wywołaniu @ref gamma_move dla kolejnych ruchów.
+ * Na dużej planszy w trybie gęstym, gdy ruchy nie są zapisywane w dzienniku,
+ * ruchy wykonywane są porcjami. Ruchy porcji na polach odległych o więcej
+ * niż dwa od pól wcześniejszych ruchów porcji, dołączające pole do jedynego
+ * sąsiedniego obszaru gracza, wykonywane są równolegle przez wątki
+ * obsługujące pasy wierszy planszy. Pozostałe ruchy porcji, które mogą
+ * zależeć od innych ruchów lub zmieniają obszary graczy, wykonywane są
+ * po nich, kolejno.
+ * @param[in,out] g     – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves     – tablica ruchów,
+ * @param[in] count     – liczba ruchów,
+ * @param[out] results  – tablica, do której zostaną zapisane wyniki
+ *                        kolejnych ruchów (jak dla @ref gamma_move),
+ *                        lub `NULL`.
+ * @return Liczba wykonanych ruchów.
+ */
+size_t gamma_move_bulk(gamma_t *g, const gamma_play_t *moves, size_t count,
+                       bool *results);
+
+
 /** @brief Wykonuje złoty ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
  * gracza, usuwając pionek innego gracza.
@@ -80,6 +353,42 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
 
+/** @brief Włącza lub wyłącza dziennik ruchów.
+ * Ruchy wykonane przy włączonym dzienniku można cofać funkcją
+ * @ref gamma_undo i powtarzać funkcją @ref gamma_redo. Dziennik zapisuje
+ * zmiany właścicieli i obszarów pól oraz liczniki graczy, więc jego rozmiar
+ * rośnie z każdym ruchem; wyłączenie go zwalnia pamięć. Gdy zabraknie
+ * pamięci na dziennik, zostaje on wyczyszczony, a ruch i tak jest
+ * wykonywany.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] enabled – @p true, żeby zacząć zapisywać ruchy (od stanu
+ *                      bieżącego), @p false, żeby przestać.
+ * @return Wartość @p true, lub @p false gdy @p g jest `NULL`-em lub gra
+ * otwarta jest tylko do odczytu.
+ */
+bool gamma_set_journal(gamma_t *g, bool enabled);
+
+
+/** @brief Cofa ostatni ruch.
+ * Przywraca dokładnie stan gry sprzed ostatniego zapisanego w dzienniku,
+ * niecofniętego ruchu (zwykłego lub złotego), w czasie proporcjonalnym
+ * do liczby pól, którym ruch zmienił właściciela lub obszar.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został cofnięty, a @p false, gdy
+ * dziennik jest wyłączony, pusty lub zabrakło pamięci.
+ */
+bool gamma_undo(gamma_t *g);
+
+
+/** @brief Powtarza ostatnio cofnięty ruch.
+ * Cofnięte ruchy można powtarzać, dopóki nie zostanie wykonany inny ruch.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli ruch został powtórzony, a @p false, gdy
+ * nie ma cofniętego ruchu lub nie udało się go wykonać.
+ */
+bool gamma_redo(gamma_t *g);
+
+
 /** @brief Podaje liczbę pól zajętych przez gracza.
  * Podaje liczbę pól zajętych przez gracza @p player.
  * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
@@ -103,6 +412,27 @@ uint64_t gamma_busy_fields(gamma_t *g, uint32_t player);
 uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
 
 
+/** @brief Wypisuje pola, na których gracz może wykonać zwykły ruch.
+ * Pola wypisywane są porcjami: kolejne wywołania z tym samym kursorem
+ * kontynuują wyliczanie, a łączna liczba wypisanych pól równa jest wyniku
+ * @ref gamma_free_fields. Przed pierwszym wywołaniem kursor należy ustawić
+ * na zero; między wywołaniami stan gry nie może się zmieniać. Koszt
+ * wywołania jest proporcjonalny do liczby wypisanych pól, a nie do rozmiaru
+ * planszy (poza pierwszym zapytaniem, które tworzy potrzebne struktury).
+ * @param[in] g           – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player      – numer gracza, liczba dodatnia niewiększa od
+ *                          wartości @p players z funkcji @ref gamma_new,
+ * @param[in, out] cursor – kursor wyliczania,
+ * @param[out] moves      – tablica, do której zostaną zapisane współrzędne
+ *                          pól,
+ * @param[in] capacity    – rozmiar tablicy @p moves.
+ * @return Liczba wypisanych pól; zero oznacza koniec wyliczania lub
+ * niepoprawne parametry.
+ */
+size_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *cursor,
+                         gamma_coords_t *moves, size_t capacity);
+
+
 /** @brief Sprawdza, czy gracz może wykonać złoty ruch.
  * Sprawdza, czy gracz @p player jeszcze nie wykonał w tej rozgrywce złotego
  * ruchu i jest przynajmniej jedno pole które może zabrać innemu graczowi.
@@ -140,6 +470,142 @@ char* gamma_board(gamma_t *g);
 bool gamma_board_buffer(gamma_t *g, char *buffer, size_t size);
 
 
+/** @brief Podaje liczbę pól zajętych przez gracza, odczytując ją z innego
+ * wątku.
+ * Funkcje `gamma_read_*` można wywoływać z wielu wątków jednocześnie
+ * z wykonywaniem ruchów (@ref gamma_move, @ref gamma_golden_move,
+ * @ref gamma_undo, @ref gamma_redo) i czyszczeniem gry (@ref gamma_reset)
+ * przez jeden wątek gry. Nie blokują one
+ * ruchów: odczyt przerwany przez ruch jest powtarzany, więc wynik zawsze
+ * odpowiada stanowi gry między ruchami. Gry ani gier utworzonych z niej
+ * przez @ref gamma_clone nie można usuwać w trakcie odczytu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wynik @ref gamma_busy_fields.
+ */
+uint64_t gamma_read_busy_fields(const gamma_t *g, uint32_t player);
+
+
+/** @brief Podaje liczbę pól, jakie jeszcze gracz może zająć, odczytując ją
+ * z innego wątku.
+ * Zobacz @ref gamma_read_busy_fields.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new.
+ * @return Wynik @ref gamma_free_fields.
+ */
+uint64_t gamma_read_free_fields(const gamma_t *g, uint32_t player);
+
+
+/** @brief Zapisuje napis opisujący stan planszy do bufora, odczytując go
+ * z innego wątku.
+ * Zobacz @ref gamma_read_busy_fields. W przeciwieństwie do
+ * @ref gamma_board_buffer funkcja nie wpływa na @ref gamma_board_update.
+ * Jeżeli ruchy wykonywane są częściej niż trwa opisanie planszy, odczyt
+ * może być powtarzany wielokrotnie.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] buffer – bufor do którego ma zostać zapisana plansza,
+ * @param[in] size    – rozmiar bufora.
+ * @return Wartość @p true jeżeli udało się umieścić napis w buforze,
+ * wartość @p false w przeciwnym wypadku lub gdy wskaźniki podane jako argumenty
+ * są niepoprawne.
+ */
+bool gamma_read_board_buffer(const gamma_t *g, char *buffer, size_t size);
+
+
+/** @brief Poprawia napis opisujący stan planszy w buforze.
+ * Bufor musi zawierać napis umieszczony w nim przez ostatnie wywołanie
+ * @ref gamma_board_buffer lub @ref gamma_board_update dla tej gry. Funkcja
+ * przepisuje jedynie pola zmienione od tego czasu, więc jej koszt zależy od
+ * liczby zmian, a nie od rozmiaru planszy. Jeżeli zmian było bardzo dużo
+ * lub plansza nie była jeszcze opisana, napis tworzony jest od nowa.
+ * Opisanie planszy w innym buforze (np. funkcją @ref gamma_board) sprawia,
+ * że kolejne poprawki dotyczą tamtego opisu.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in, out] buffer – bufor z opisem planszy,
+ * @param[in] size    – rozmiar bufora.
+ * @return Wartość @p true jeżeli udało się umieścić napis w buforze,
+ * wartość @p false w przeciwnym wypadku lub gdy wskaźniki podane jako argumenty
+ * są niepoprawne.
+ */
+bool gamma_board_update(gamma_t *g, char *buffer, size_t size);
+
+
+/** @brief Wypisuje fragment planszy do strumienia.
+ * Wypisuje prostokąt planszy złożony z kolumn od @p x do `x + width - 1`
+ * i wierszy od @p y do `y + height - 1` w formacie @ref gamma_board
+ * (od górnego wiersza, identyfikatory w blokach o długości ilości cyfr
+ * w liczbie graczy). Tekst tworzony jest w porcjach o ograniczonym rozmiarze,
+ * więc funkcja nie przydziela pamięci zależnej od rozmiaru planszy. Dla
+ * pustego prostokąta nic nie jest wypisywane.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] stream  – strumień wyjściowy,
+ * @param[in] x       – numer pierwszej kolumny,
+ * @param[in] y       – numer pierwszego (dolnego) wiersza,
+ * @param[in] width   – liczba kolumn,
+ * @param[in] height  – liczba wierszy.
+ * @return Wartość @p true jeżeli udało się wypisać fragment, @p false jeżeli
+ * prostokąt wykracza poza planszę, zapis się nie powiódł lub parametry są
+ * niepoprawne.
+ */
+bool gamma_board_fwrite(gamma_t *g, FILE *stream, uint32_t x, uint32_t y,
+                        uint32_t width, uint32_t height);
+
+
+/** @brief Wypisuje fragment planszy do deskryptora pliku.
+ * Działa jak @ref gamma_board_fwrite, ale zapisuje tekst funkcją `write`.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] fd      – deskryptor pliku,
+ * @param[in] x       – numer pierwszej kolumny,
+ * @param[in] y       – numer pierwszego (dolnego) wiersza,
+ * @param[in] width   – liczba kolumn,
+ * @param[in] height  – liczba wierszy.
+ * @return Wartość @p true jeżeli udało się wypisać fragment, @p false jeżeli
+ * prostokąt wykracza poza planszę, zapis się nie powiódł lub parametry są
+ * niepoprawne.
+ */
+bool gamma_board_write(gamma_t *g, int fd, uint32_t x, uint32_t y,
+                       uint32_t width, uint32_t height);
+
+
+/** @brief Daje widok tablicy właścicieli pól.
+ * Widok wskazuje bezpośrednio na pamięć planszy, więc odczyt nie wymaga
+ * kopiowania ani wywołań funkcji dla każdego pola. Pamięć pozostaje ważna
+ * do usunięcia gry i zmienia się razem z planszą; zgodność odczytu można
+ * sprawdzić porównując @ref gamma_view::version z @ref gamma_version po
+ * odczycie. Widok dostępny jest jedynie dla plansz przechowywanych w jednej
+ * tablicy w układzie wierszowym; dla pozostałych należy użyć
+ * @ref gamma_gather.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] view   – opis widoku.
+ * @return Wartość @p true jeżeli widok został utworzony, @p false jeżeli
+ * plansza nie ma takiej tablicy lub parametry są niepoprawne.
+ */
+bool gamma_view(const gamma_t *g, gamma_view_t *view);
+
+
+/** @brief Podaje numer wersji planszy.
+ * Numer zwiększa się przy każdej zmianie właściciela któregoś z pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Numer wersji lub zero gdy podany parametr jest niepoprawny.
+ */
+uint64_t gamma_version(const gamma_t *g);
+
+
+/** @brief Odczytuje właścicieli listy pól.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] coords  – współrzędne pól,
+ * @param[in] count   – liczba pól,
+ * @param[out] owners – tablica, do której zostaną zapisani właściciele pól
+ *                      (`0` dla wolnych pól i niepoprawnych współrzędnych).
+ * @return Wartość @p true jeżeli wszystkie współrzędne były poprawne,
+ * @p false w przeciwnym wypadku lub gdy parametry są niepoprawne.
+ */
+bool gamma_gather(const gamma_t *g, const gamma_coords_t *coords, size_t count,
+                  uint32_t *owners);
+
+
 /** @brief Podaje szerokość planszy.
  * Funkcja zwraca wartość parametru `width` podanego przy wywołaniu
  * funkcji @ref gamma_new.
@@ -10,6 +10,7 @@
 #include "input_interface.h"
 #include "batch_mode.h"
 #include "interactive_mode.h"
+#include "multi_batch.h"
 #include "isnull.h"
 
 
@@ -47,6 +48,20 @@ int main() {
                 // Niepoprawne parametry planszy.
                 report_error();
             }
+        } else if ((resp == 0 || resp == 1) && mode == 'M') {
+            // Tryb wielu gier; gry tworzone są dopiero jego poleceniami.
+            report_ok();
+            break;
+        } else if (resp == 1 && mode == 'L') {
+            engine = batch_snapshot_load(params[0]);
+            if (!ISNULL(engine)) {
+                // Migawka gry została wczytana.
+                report_ok();
+                break;
+            } else {
+                // Brak migawki lub jest ona niepoprawna.
+                report_error();
+            }
         } else if (resp >= 0) {
             // Zła liczba parametrów lub nieodpowiedni tryb programu.
             report_error();
@@ -54,13 +69,18 @@ int main() {
     }
     switch (mode) {
         case 'B':
+        case 'L':
             // Przejście do trybu wsadowego.
-            batch_run(engine);
+            batch_run(&engine);
             break;
         case 'I':
             // Przejście do trybu interaktywnego.
             interactive_run(engine);
             break;
+        case 'M':
+            // Przejście do wsadowego trybu wielu gier.
+            multi_batch_run(resp == 1 ? params[0] : 0);
+            break;
         default:
             break;
     }
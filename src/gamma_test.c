@@ -5,6 +5,8 @@
  * @copyright Uniwersytet Warszawski
  * @date 12.06.2020
  */
+/* Test trybu wielu gier uruchamia go w procesie potomnym. */
+#define _POSIX_C_SOURCE 200809L
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
@@ -12,6 +14,7 @@
 
 /* Ten plik włączamy na początku. */
 #include "gamma.h"
+#include "multi_batch.h"
 
 /* CMake w wersji release wyłącza asercje. */
 #ifdef NDEBUG
@@ -22,7 +25,13 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 /** KONFIGUARACJA TESTÓW **/
 
@@ -720,6 +729,780 @@ static void middle_board(void **state) {
 }
 
 
+/* Testuje odbudowę list kandydatów na złoty ruch wieloma wątkami w kopii
+ * gry i w grze wczytanej z migawki. */
+static void parallel_golden(void **state) {
+    (void) state;
+    gamma_options_t options = {.storage = GAMMA_STORAGE_DENSE, .threads = 4};
+    gamma_t *g = gamma_new_ext(1024, 1024, 4, 2, &options);
+    assert_non_null(g);
+    /* Obszary graczy leżą w różnych pasach planszy. Gracz 3 przylega
+     * jedynie do pola, którego zdjęcie rozspójni obszar gracza 2. */
+    for (uint32_t x = 0; x < 10; ++x) {
+        assert_true(gamma_move(g, 1, x, 600));
+        assert_true(gamma_move(g, 2, x, 601));
+    }
+    assert_true(gamma_move(g, 1, 10, 100));
+    assert_true(gamma_move(g, 2, 20, 900));
+    assert_true(gamma_move(g, 3, 5, 602));
+    assert_true(gamma_move(g, 3, 30, 300));
+    assert_true(gamma_move(g, 4, 11, 100));
+    assert_true(gamma_move(g, 4, 40, 800));
+    FILE *stream = tmpfile();
+    assert_non_null(stream);
+    assert_true(gamma_save(g, stream));
+    rewind(stream);
+    gamma_t *copies[] = {gamma_clone(g), gamma_load(stream, &options)};
+    fclose(stream);
+    assert_non_null(copies[0]);
+    assert_non_null(copies[1]);
+    static const bool possible[] = {true, true, false, true};
+    for (uint32_t player = 1; player <= 4; ++player) {
+        assert_int_equal(gamma_golden_possible(g, player),
+                         possible[player - 1]);
+        for (size_t i = 0; i < SIZE(copies); ++i) {
+            assert_int_equal(gamma_golden_possible(copies[i], player),
+                             possible[player - 1]);
+        }
+    }
+    static const gamma_play_t moves[] = {
+            {3, 5, 601}, {4, 10, 100}, {1, 5, 601}, {2, 5, 602},
+            {1, 11, 100}, {3, 0, 601}, {2, 0, 600}, {4, 9, 600}};
+    for (size_t m = 0; m < SIZE(moves); ++m) {
+        bool result = gamma_golden_move(g, moves[m].player, moves[m].x,
+                                        moves[m].y);
+        assert_true(m > 1 || result == (m == 1));
+        for (size_t i = 0; i < SIZE(copies); ++i) {
+            assert_int_equal(gamma_golden_move(copies[i], moves[m].player,
+                                               moves[m].x, moves[m].y),
+                             result);
+            for (uint32_t player = 1; player <= 4; ++player) {
+                assert_int_equal(gamma_golden_possible(copies[i], player),
+                                 gamma_golden_possible(g, player));
+            }
+        }
+    }
+    char *expected = gamma_board(g);
+    assert_non_null(expected);
+    for (size_t i = 0; i < SIZE(copies); ++i) {
+        char *board = gamma_board(copies[i]);
+        assert_non_null(board);
+        assert_string_equal(board, expected);
+        free(board);
+        gamma_delete(copies[i]);
+    }
+    free(expected);
+    gamma_delete(g);
+}
+
+
+/* Testuje zgodność gier o polach ułożonych wierszami i w kwadratach na
+ * planszy o bokach niepodzielnych przez 8. */
+static void layouts(void **state) {
+    (void) state;
+    static const gamma_storage_t storages[] = {GAMMA_STORAGE_DENSE,
+                                               GAMMA_STORAGE_SPARSE,
+                                               GAMMA_STORAGE_BITBOARD};
+    for (size_t i = 0; i < SIZE(storages); ++i) {
+        gamma_options_t rows = {.storage = storages[i],
+                                .layout = GAMMA_LAYOUT_ROWS};
+        gamma_options_t squares = {.storage = storages[i],
+                                   .layout = GAMMA_LAYOUT_SQUARES};
+        gamma_t *g = gamma_new_ext(13, 21, 3, 20, &rows);
+        gamma_t *h = gamma_new_ext(13, 21, 3, 20, &squares);
+        assert_non_null(g);
+        assert_non_null(h);
+        uint32_t seed = 1;
+        for (uint32_t move = 0; move < 400; ++move) {
+            seed = seed * 1103515245 + 12345;
+            uint32_t player = seed % 3 + 1;
+            uint32_t x = (seed >> 8) % 13, y = (seed >> 16) % 21;
+            if (move % 10 == 9) {
+                assert_int_equal(gamma_golden_move(g, player, x, y),
+                                 gamma_golden_move(h, player, x, y));
+            } else {
+                assert_int_equal(gamma_move(g, player, x, y),
+                                 gamma_move(h, player, x, y));
+            }
+        }
+        for (uint32_t player = 1; player <= 3; ++player) {
+            assert_true(gamma_busy_fields(g, player)
+                        == gamma_busy_fields(h, player));
+            assert_true(gamma_free_fields(g, player)
+                        == gamma_free_fields(h, player));
+            assert_int_equal(gamma_golden_possible(g, player),
+                             gamma_golden_possible(h, player));
+        }
+        assert_true(gamma_busy_fields(g, 1) > 0);
+        char *expected = gamma_board(g), *board = gamma_board(h);
+        assert_non_null(expected);
+        assert_non_null(board);
+        assert_string_equal(board, expected);
+        free(expected);
+        free(board);
+        gamma_delete(g);
+        gamma_delete(h);
+    }
+}
+
+
+/* Stan licznika wywołań funkcji przydzielających pamięć grze. */
+typedef struct counting_allocator {
+    bool fail; /* Czy odmawiać przydzielenia pamięci. */
+    int allocs; /* Liczba wywołań alloc. */
+    int frees; /* Liczba wywołań free. */
+    void *memory; /* Ostatnio przydzielony blok. */
+    size_t size; /* Rozmiar ostatnio przydzielonego bloku. */
+    size_t alignment; /* Wyrównanie ostatnio przydzielonego bloku. */
+} counting_allocator_t;
+
+
+/* Przydziela wyzerowany blok i zapamiętuje jego rozmiar i wyrównanie. */
+static void *counting_alloc(void *context, size_t size, size_t alignment) {
+    counting_allocator_t *counter = context;
+    counter->allocs++;
+    if (counter->fail) {
+        return NULL;
+    }
+    size_t rounded = (size + alignment - 1) / alignment * alignment;
+    void *memory = aligned_alloc(alignment, rounded);
+    assert_non_null(memory);
+    memset(memory, 0, rounded);
+    counter->memory = memory;
+    counter->size = size;
+    counter->alignment = alignment;
+    return memory;
+}
+
+
+/* Zwalnia blok, sprawdzając, że to ostatnio przydzielony blok. */
+static void counting_free(void *context, void *memory, size_t size) {
+    counting_allocator_t *counter = context;
+    counter->frees++;
+    assert_true(memory == counter->memory);
+    assert_true(size == counter->size);
+    free(memory);
+}
+
+
+/* Testuje przydzielanie pamięci gry funkcjami podanymi w opcjach. */
+static void allocator(void **state) {
+    (void) state;
+    counting_allocator_t counter = {0};
+    gamma_allocator_t functions = {.alloc = counting_alloc,
+                                   .free = counting_free,
+                                   .context = &counter};
+    gamma_options_t options = {.allocator = &functions};
+    gamma_t *g = gamma_new_ext(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 2,
+                               &options);
+    assert_non_null(g);
+    assert_int_equal(counter.allocs, 1);
+    assert_int_equal(counter.frees, 0);
+    assert_true(counter.size > 0);
+    assert_true(counter.alignment > 0);
+    assert_int_equal(counter.alignment & (counter.alignment - 1), 0);
+    assert_int_equal((uintptr_t) counter.memory % counter.alignment, 0);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_golden_move(g, 2, 0, 0));
+    gamma_delete(g);
+    assert_int_equal(counter.allocs, 1);
+    assert_int_equal(counter.frees, 1);
+
+    counter.fail = true;
+    assert_null(gamma_new_ext(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 2,
+                              &options));
+    assert_int_equal(counter.allocs, 2);
+    assert_int_equal(counter.frees, 1);
+}
+
+
+/* Testuje grę przechowywaną w pliku i jej ponowne otwarcie. */
+static void file_board(void **state) {
+    (void) state;
+    static const char path[] = "gamma_test.board";
+    gamma_options_t options = {.path = path};
+    gamma_t *g = gamma_new_ext(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 1,
+                               &options);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 1, 1, 0));
+    assert_true(gamma_move(g, 2, 2, 0));
+    char *before = gamma_board(g);
+    assert_non_null(before);
+    gamma_delete(g);
+
+    g = gamma_open(path);
+    assert_non_null(g);
+    assert_null(gamma_open(path));
+    assert_true(gamma_width(g) == SMALL_BOARD_SIZE);
+    assert_true(gamma_players(g) == 2);
+    char *after = gamma_board(g);
+    assert_non_null(after);
+    assert_string_equal(before, after);
+    free(before);
+    free(after);
+    assert_true(gamma_busy_fields(g, 1) == 2);
+    assert_true(gamma_free_fields(g, 1) == 2);
+    assert_false(gamma_move(g, 1, 5, 5));
+    assert_true(gamma_golden_possible(g, 2));
+    assert_true(gamma_golden_move(g, 2, 1, 0));
+    gamma_delete(g);
+
+    g = gamma_open(path);
+    assert_non_null(g);
+    assert_true(gamma_busy_fields(g, 2) == 2);
+    assert_false(gamma_golden_possible(g, 2));
+    assert_true(gamma_golden_possible(g, 1));
+    assert_true(gamma_golden_move(g, 1, 1, 0));
+    gamma_delete(g);
+
+    g = gamma_open_readonly(path);
+    assert_non_null(g);
+    gamma_t *h = gamma_open_readonly(path);
+    assert_non_null(h);
+    assert_true(gamma_busy_fields(h, 1) == 2);
+    assert_true(gamma_free_fields(h, 2) == 2);
+    assert_false(gamma_golden_move(h, 1, 2, 0));
+    assert_false(gamma_move(h, 2, 3, 0));
+    gamma_delete(h);
+    assert_true(gamma_busy_fields(g, 2) == 1);
+    assert_false(gamma_golden_possible(g, 1));
+    gamma_delete(g);
+    g = gamma_open(path);
+    assert_non_null(g);
+    assert_null(gamma_open_readonly(path));
+    gamma_delete(g);
+    assert_int_equal(remove(path), 0);
+
+    options.storage = GAMMA_STORAGE_SPARSE;
+    assert_null(gamma_new_ext(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 1,
+                              &options));
+}
+
+
+/* Testuje łączenie obszarów na zapełnionej planszy otwartej z pliku. */
+static void file_reopen(void **state) {
+    (void) state;
+    static const char path[] = "gamma_test_reopen.board";
+    gamma_options_t options = {.path = path};
+    gamma_t *g = gamma_new_ext(100, 3, 1, 2, &options);
+    assert_non_null(g);
+    for (uint32_t x = 0; x < 40; ++x) {
+        assert_true(gamma_move(g, 1, x, 0));
+        assert_true(gamma_move(g, 1, x, 2));
+    }
+    gamma_delete(g);
+
+    g = gamma_open(path);
+    assert_non_null(g);
+    assert_false(gamma_move(g, 1, 50, 1));
+    assert_true(gamma_move(g, 1, 0, 1));
+    assert_true(gamma_busy_fields(g, 1) == 81);
+    assert_true(gamma_move(g, 1, 50, 1));
+    gamma_delete(g);
+    assert_int_equal(remove(path), 0);
+}
+
+/* Testuje uaktualnianie napisu opisującego planszę. */
+static void board_update(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 12, 3);
+    assert_non_null(g);
+    char *board = gamma_board(g);
+    assert_non_null(board);
+    size_t size = strlen(board) + 1;
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 12, 1, 0));
+    assert_true(gamma_golden_move(g, 1, 1, 0));
+    assert_true(gamma_board_update(g, board, size));
+    char *expected = gamma_board(g);
+    assert_non_null(expected);
+    assert_string_equal(board, expected);
+    assert_true(gamma_move(g, 2, 5, 5));
+    assert_true(gamma_board_update(g, board, size));
+    assert_false(gamma_board_update(g, board, size - SMALL_BOARD_SIZE));
+    free(expected);
+    expected = gamma_board(g);
+    assert_string_equal(board, expected);
+    free(expected);
+    free(board);
+    gamma_delete(g);
+}
+
+/* Testuje bezpośredni wgląd w tablicę właścicieli pól i odczyt wielu pól. */
+static void board_view(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 300, 3);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 300, 3, 2));
+    gamma_view_t view;
+    assert_true(gamma_view(g, &view));
+    assert_int_equal(view.owner_size, sizeof(uint16_t));
+    assert_true(view.version == gamma_version(g));
+    const uint16_t *owners = view.owners;
+    assert_int_equal(owners[0], 1);
+    assert_int_equal(owners[2 * view.row_stride + 3], 300);
+    assert_int_equal(owners[2 * view.row_stride + 4], 0);
+
+    gamma_coords_t coords[] = {{0, 0}, {3, 2}, {4, 2}, {SMALL_BOARD_SIZE, 0}};
+    uint32_t gathered[4];
+    assert_false(gamma_gather(g, coords, 4, gathered));
+    assert_int_equal(gathered[0], 1);
+    assert_int_equal(gathered[1], 300);
+    assert_int_equal(gathered[2], 0);
+    assert_int_equal(gathered[3], 0);
+    assert_true(gamma_gather(g, coords, 3, gathered));
+    assert_true(gamma_golden_move(g, 1, 3, 2));
+    assert_true(gamma_version(g) > view.version);
+    assert_int_equal(owners[2 * view.row_stride + 3], 1);
+    gamma_delete(g);
+}
+
+/* Testuje wypisywanie prostokątnego fragmentu planszy do strumienia. */
+static void board_write(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 12, 3);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 1, 1));
+    assert_true(gamma_move(g, 12, 2, 2));
+    FILE *stream = tmpfile();
+    assert_non_null(stream);
+    assert_true(gamma_board_fwrite(g, stream, 1, 1, 3, 2));
+    assert_true(gamma_board_fwrite(g, stream, 0, 0, 0, SMALL_BOARD_SIZE));
+    assert_false(gamma_board_fwrite(g, stream, 1, 0, SMALL_BOARD_SIZE, 1));
+    assert_false(gamma_board_fwrite(g, NULL, 0, 0, 1, 1));
+    char text[32] = "";
+    rewind(stream);
+    assert_int_equal(fread(text, sizeof(char), sizeof(text) - 1, stream), 14);
+    assert_string_equal(text, " .12 .\n 1 . .\n");
+    fclose(stream);
+    gamma_delete(g);
+}
+
+/* Testuje zapis i odczyt migawki gry oraz odrzucanie uszkodzonej migawki. */
+static void snapshot(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 1, 2, 0));
+    assert_true(gamma_move(g, 2, 1, 0));
+    assert_true(gamma_golden_move(g, 3, 1, 0));
+    FILE *stream = tmpfile();
+    assert_non_null(stream);
+    assert_true(gamma_save(g, stream));
+    rewind(stream);
+    gamma_t *h = gamma_load(stream, NULL);
+    assert_non_null(h);
+    char *before = gamma_board(g);
+    char *after = gamma_board(h);
+    assert_string_equal(before, after);
+    free(before);
+    free(after);
+    for (uint32_t player = 1; player <= 3; ++player) {
+        assert_int_equal(gamma_busy_fields(g, player),
+                         gamma_busy_fields(h, player));
+        assert_int_equal(gamma_free_fields(g, player),
+                         gamma_free_fields(h, player));
+        assert_int_equal(gamma_golden_possible(g, player),
+                         gamma_golden_possible(h, player));
+    }
+    assert_false(gamma_golden_move(h, 3, 0, 0));
+    assert_true(gamma_move(h, 2, 3, 0));
+    assert_true(gamma_move(h, 2, 3, 3));
+    assert_false(gamma_move(h, 2, 1, 3));
+    gamma_delete(h);
+    /* Migawka kończy się 32-bajtowymi licznikami graczy; zmieniamy liczbę
+     * wolnych pól przy polach pierwszego gracza. */
+    assert_int_equal(fseek(stream, -3 * 32 + 8, SEEK_END), 0);
+    int counter = fgetc(stream);
+    assert_int_equal(fseek(stream, -3 * 32 + 8, SEEK_END), 0);
+    assert_int_equal(fputc(counter + 1, stream), counter + 1);
+    rewind(stream);
+    assert_null(gamma_load(stream, NULL));
+    rewind(stream);
+    assert_int_equal(fputc(0, stream), 0);
+    rewind(stream);
+    assert_null(gamma_load(stream, NULL));
+    fclose(stream);
+    gamma_delete(g);
+}
+
+/* Testuje kopie gry współdzielące fragmenty planszy w trybie rzadkim. */
+static void clone(void **state) {
+    (void) state;
+    gamma_options_t options = {.storage = GAMMA_STORAGE_SPARSE};
+    gamma_t *g = gamma_new_ext(BIG_BOARD_SIZE, BIG_BOARD_SIZE, 2, 2, &options);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 1, 1, 0));
+    assert_true(gamma_move(g, 2, 2, 0));
+    assert_true(gamma_move(g, 2, BIG_BOARD_SIZE - 1, BIG_BOARD_SIZE - 1));
+    gamma_t *c = gamma_clone(g);
+    assert_non_null(c);
+    assert_true(gamma_golden_move(c, 2, 1, 0));
+    assert_true(gamma_move(g, 1, 0, 1));
+    assert_true(gamma_busy_fields(g, 1) == 3);
+    assert_true(gamma_busy_fields(c, 1) == 1);
+    assert_true(gamma_busy_fields(c, 2) == 3);
+    assert_true(gamma_golden_possible(g, 2));
+    assert_false(gamma_golden_possible(c, 2));
+    gamma_t *d = gamma_clone(c);
+    gamma_delete(c);
+    assert_non_null(d);
+    assert_true(gamma_move(d, 1, 0, 1));
+    assert_true(gamma_move(d, 2, 3, 0));
+    assert_true(gamma_busy_fields(g, 2) == 2);
+    gamma_delete(g);
+    assert_true(gamma_busy_fields(d, 2) == 4);
+    gamma_delete(d);
+    assert_null(gamma_clone(NULL));
+}
+
+/* Testuje cofanie i powtarzanie ruchów. */
+static void undo_redo(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(5, 5, 2, 2);
+    assert_non_null(g);
+    assert_false(gamma_undo(g));
+    assert_true(gamma_set_journal(g, true));
+    assert_false(gamma_undo(g));
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 1, 2, 0));
+    assert_true(gamma_move(g, 2, 1, 0));
+    char *before = gamma_board(g);
+    assert_non_null(before);
+    assert_true(gamma_golden_move(g, 1, 1, 0));
+    assert_true(gamma_busy_fields(g, 1) == 3);
+    assert_true(gamma_busy_fields(g, 2) == 0);
+    assert_true(gamma_undo(g));
+    char *after = gamma_board(g);
+    assert_non_null(after);
+    assert_string_equal(before, after);
+    free(before);
+    free(after);
+    assert_true(gamma_busy_fields(g, 2) == 1);
+    assert_true(gamma_golden_possible(g, 1));
+    assert_true(gamma_free_fields(g, 1) == 3);
+    assert_true(gamma_redo(g));
+    assert_false(gamma_redo(g));
+    assert_false(gamma_golden_possible(g, 1));
+    assert_true(gamma_undo(g));
+    assert_true(gamma_undo(g));
+    assert_true(gamma_move(g, 2, 1, 1));
+    assert_false(gamma_redo(g));
+    assert_true(gamma_busy_fields(g, 1) == 2);
+    assert_true(gamma_set_journal(g, false));
+    assert_false(gamma_undo(g));
+    gamma_delete(g);
+}
+
+/* Testuje wypisywanie dozwolonych ruchów gracza porcjami. */
+static void legal_moves(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(70, 2, 2, 1);
+    assert_non_null(g);
+    gamma_coords_t moves[50];
+    uint64_t cursor = 0;
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 50);
+    assert_true(moves[0].x == 0 && moves[0].y == 0);
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 50);
+    assert_true(moves[20].x == 0 && moves[20].y == 1);
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 40);
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 0);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 2, 1, 0));
+    cursor = 0;
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 1);
+    assert_true(moves[0].x == 0 && moves[0].y == 1);
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 50) == 0);
+    cursor = 0;
+    assert_true(gamma_legal_moves(g, 2, &cursor, moves, 50) == 2);
+    assert_true(gamma_legal_moves(g, 3, &cursor, moves, 50) == 0);
+    gamma_delete(g);
+}
+
+
+/* Szerokość planszy gry czytanej z innego wątku. */
+#define READ_WIDTH 64
+/* Wysokość planszy gry czytanej z innego wątku. */
+#define READ_HEIGHT 48
+/* Liczba ruchów wykonywanych w trakcie czytania gry. */
+#define READ_MOVES 5000
+
+
+/* Stan wątku czytającego grę w trakcie ruchów. */
+typedef struct reader {
+    gamma_t *g; /* Czytana gra. */
+    uint32_t order[READ_HEIGHT][READ_WIDTH]; /* Numer udanego ruchu, który
+                                              * zajmuje pole, lub
+                                              * `UINT32_MAX`. */
+    char owner[READ_HEIGHT][READ_WIDTH]; /* Znak gracza zajmującego pole. */
+    atomic_bool stop; /* Czy zakończyć czytanie. */
+    uint64_t checked; /* Liczba odczytów, które można porównać. */
+    uint64_t failed; /* Liczba niezgodnych odczytów. */
+} reader_t;
+
+
+/* Ruch numer @p move wykonywany w trakcie czytania gry. */
+static gamma_play_t read_move(uint32_t move) {
+    uint32_t seed = move * 2654435761u + 12345;
+    seed ^= seed >> 13;
+    seed *= 1103515245;
+    return (gamma_play_t) {.player = move % 2 + 1,
+                           .x = (seed >> 8) % READ_WIDTH,
+                           .y = (seed >> 16) % READ_HEIGHT};
+}
+
+
+/* Suma pól zajętych przez obu graczy, odczytana z innego wątku. */
+static uint64_t read_busy(const gamma_t *g) {
+    return gamma_read_busy_fields(g, 1) + gamma_read_busy_fields(g, 2);
+}
+
+
+/* Sprawdza, czy plansza odpowiada stanowi po pewnej liczbie udanych ruchów,
+ * czyli czy zajmuje ją dokładnie tyle pierwszych ruchów, ile ma zajętych pól.
+ * @return Liczba zajętych pól lub `UINT64_MAX` dla niespójnej planszy. */
+static uint64_t read_check_board(const reader_t *reader, const char *board) {
+    uint64_t taken = 0;
+    for (uint32_t y = 0; y < READ_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < READ_WIDTH; ++x) {
+            taken += board[(READ_HEIGHT - 1 - y) * (READ_WIDTH + 1) + x] != '.';
+        }
+    }
+    for (uint32_t y = 0; y < READ_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < READ_WIDTH; ++x) {
+            char c = board[(READ_HEIGHT - 1 - y) * (READ_WIDTH + 1) + x];
+            char expected = reader->order[y][x] < taken ? reader->owner[y][x]
+                                                        : '.';
+            if (c != expected) {
+                return UINT64_MAX;
+            }
+        }
+    }
+    return taken;
+}
+
+
+/* Czyta grę, dopóki główny wątek wykonuje ruchy. Każda wczytana plansza
+ * musi być stanem po pewnej liczbie ruchów. Liczba zajętych pól tylko
+ * rośnie, więc jeśli jest taka sama przed i po odczytach, nie wykonano
+ * między nimi ruchu i odczyty muszą być ze sobą zgodne. Asercje sprawdzane
+ * są w głównym wątku, więc niezgodne odczyty są jedynie zliczane. */
+static void *reader_run(void *arg) {
+    reader_t *reader = arg;
+    static char board[(READ_WIDTH + 1) * READ_HEIGHT + 1];
+    uint64_t last = 0;
+    bool stop;
+    do {
+        stop = atomic_load(&reader->stop);
+        uint64_t before = read_busy(reader->g);
+        uint64_t free_fields = gamma_read_free_fields(reader->g, 1);
+        bool read = gamma_read_board_buffer(reader->g, board, sizeof(board));
+        uint64_t after = read_busy(reader->g);
+        uint64_t taken = read ? read_check_board(reader, board) : UINT64_MAX;
+        reader->failed += taken == UINT64_MAX || before < last
+                          || after < before || taken < before || taken > after;
+        last = after;
+        if (before == after) {
+            reader->failed += before + free_fields
+                              != READ_WIDTH * READ_HEIGHT;
+            reader->checked++;
+        }
+    } while (!stop);
+    return NULL;
+}
+
+
+/* Testuje odczyt stanu gry z innego wątku w trakcie wykonywania ruchów. */
+static void concurrent_reads(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(4, 3, 2, 1);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 2, 3, 2));
+    assert_true(gamma_read_busy_fields(g, 1) == gamma_busy_fields(g, 1));
+    assert_true(gamma_read_free_fields(g, 1) == gamma_free_fields(g, 1));
+    assert_true(gamma_read_free_fields(g, 3) == 0);
+    char buffer[16];
+    assert_true(gamma_read_board_buffer(g, buffer, sizeof(buffer)));
+    assert_string_equal(buffer, "...2\n....\n1...\n");
+    assert_false(gamma_read_board_buffer(g, buffer, 8));
+    gamma_delete(g);
+
+    /* Kolejność zajmowania pól wyznaczana jest w osobnej grze. */
+    static reader_t reader;
+    memset(reader.order, 0xff, sizeof(reader.order));
+    g = gamma_new(READ_WIDTH, READ_HEIGHT, 2, READ_WIDTH * READ_HEIGHT);
+    assert_non_null(g);
+    uint32_t taken = 0;
+    for (uint32_t move = 0; move < READ_MOVES; ++move) {
+        gamma_play_t play = read_move(move);
+        if (gamma_move(g, play.player, play.x, play.y)) {
+            reader.order[play.y][play.x] = taken++;
+            reader.owner[play.y][play.x] = (char) ('0' + play.player);
+        }
+    }
+    gamma_delete(g);
+    assert_true(taken > READ_WIDTH * READ_HEIGHT / 2);
+
+    reader.g = gamma_new(READ_WIDTH, READ_HEIGHT, 2, READ_WIDTH * READ_HEIGHT);
+    assert_non_null(reader.g);
+    atomic_init(&reader.stop, false);
+    pthread_t thread;
+    assert_int_equal(pthread_create(&thread, NULL, reader_run, &reader), 0);
+    for (uint32_t move = 0; move < READ_MOVES; ++move) {
+        gamma_play_t play = read_move(move);
+        gamma_move(reader.g, play.player, play.x, play.y);
+        if (move % 16 == 0) {
+            /* Ruchy przeplatają się z odczytami także na jednym procesorze. */
+            sched_yield();
+        }
+    }
+    atomic_store(&reader.stop, true);
+    assert_int_equal(pthread_join(thread, NULL), 0);
+    assert_true(reader.checked > 0);
+    assert_true(reader.failed == 0);
+    assert_true(read_busy(reader.g) == taken);
+    gamma_delete(reader.g);
+}
+
+
+/* Uruchamia tryb wielu gier w procesie potomnym i porównuje jego wyjście. */
+static void multi_run(const char *input, const char *output,
+                      const char *errors) {
+    static const char in_path[] = "gamma_test_multi.in";
+    static const char out_path[] = "gamma_test_multi.out";
+    static const char err_path[] = "gamma_test_multi.err";
+    FILE *file = fopen(in_path, "w");
+    assert_non_null(file);
+    fputs(input, file);
+    fclose(file);
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    assert_true(pid >= 0);
+    if (pid == 0) {
+        if (freopen(in_path, "r", stdin) == NULL
+                || freopen(out_path, "w", stdout) == NULL
+                || freopen(err_path, "w", stderr) == NULL) {
+            _exit(EXIT_FAILURE);
+        }
+        multi_batch_run(1);
+    }
+    int status;
+    assert_true(waitpid(pid, &status, 0) == pid);
+    assert_true(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    const char *paths[] = {out_path, err_path};
+    const char *expected[] = {output, errors};
+    for (size_t i = 0; i < SIZE(paths); ++i) {
+        char buffer[256];
+        file = fopen(paths[i], "r");
+        assert_non_null(file);
+        size_t size = fread(buffer, 1, sizeof(buffer) - 1, file);
+        fclose(file);
+        buffer[size] = '\0';
+        assert_string_equal(buffer, expected[i]);
+        assert_int_equal(remove(paths[i]), 0);
+    }
+    assert_int_equal(remove(in_path), 0);
+}
+
+
+/* Testuje ponowną deklarację gry w trybie wielu gier. */
+static void multi_redeclare(void **state) {
+    (void) state;
+    multi_run("B 1 3 3 2 2\n"
+              "B 1 5 5 2 2\n"
+              "m 1 1 4 4\n"
+              "d 1\n"
+              "B 1 5 5 2 2\n"
+              "m 1 1 4 4\n",
+              "1 OK 1\n1 0\n1 OK 4\n1 OK 5\n1 1\n",
+              "ERROR 2\n");
+}
+
+/* Testuje czyszczenie gry i ponowne używanie silników z puli. */
+static void reset_pool(void **state) {
+    (void) state;
+    gamma_t *g = gamma_new(70, 2, 2, 2);
+    assert_non_null(g);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_true(gamma_move(g, 2, 69, 1));
+    assert_true(gamma_golden_move(g, 1, 69, 1));
+    gamma_coords_t moves[2];
+    uint64_t cursor = 0;
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 2) == 2);
+    assert_true(gamma_reset(g));
+    assert_true(gamma_busy_fields(g, 1) == 0);
+    assert_true(gamma_free_fields(g, 1) == 140);
+    assert_false(gamma_golden_possible(g, 2));
+    cursor = 0;
+    assert_true(gamma_legal_moves(g, 1, &cursor, moves, 2) == 2);
+    assert_true(moves[0].x == 0 && moves[0].y == 0);
+    assert_true(gamma_move(g, 2, 69, 1));
+    assert_true(gamma_golden_move(g, 1, 69, 1));
+
+    gamma_pool_t *pool = gamma_pool_new(1);
+    assert_non_null(pool);
+    gamma_pool_put(pool, g);
+    assert_null(gamma_pool_get(pool, 70, 2, 2, 0));
+    gamma_t *other = gamma_pool_get(pool, 70, 2, 3, 1);
+    assert_true(other != g);
+    assert_true(gamma_pool_get(pool, 70, 2, 2, 1) == g);
+    assert_true(gamma_busy_fields(g, 1) == 0);
+    assert_true(gamma_move(g, 1, 0, 0));
+    assert_false(gamma_move(g, 1, 2, 0));
+    gamma_pool_put(pool, g);
+    gamma_pool_put(pool, other);
+    gamma_pool_delete(pool);
+}
+
+/* Testuje zgodność ruchów wykonanych wsadowo z ruchami wykonanymi po kolei. */
+static void move_bulk(void **state) {
+    (void) state;
+    gamma_options_t options = { .storage = GAMMA_STORAGE_DENSE, .threads = 4 };
+    gamma_t *bulk = gamma_new_ext(1024, 1024, 3, 1000, &options);
+    gamma_t *single = gamma_new_ext(1024, 1024, 3, 1000, &options);
+    assert_non_null(bulk);
+    assert_non_null(single);
+    static gamma_play_t moves[3][600];
+    static bool results[600];
+    for (uint32_t i = 0; i < 600; ++i) {
+        uint32_t x = i % 30 * 32, y = i / 30 * 48;
+        moves[0][i] = (gamma_play_t) { .player = i % 3 + 1, .x = x, .y = y };
+        moves[1][i] = (gamma_play_t) { .player = i % 3 + 1, .x = x + 1,
+                                       .y = y };
+        moves[2][i] = (gamma_play_t) { .player = (i + 1) % 3 + 1, .x = x + 1,
+                                       .y = y + i % 2 };
+    }
+    for (uint32_t round = 0; round < 3; ++round) {
+        size_t done = 0;
+        for (uint32_t i = 0; i < 600; ++i) {
+            done += gamma_move(single, moves[round][i].player,
+                               moves[round][i].x, moves[round][i].y);
+        }
+        assert_true(gamma_move_bulk(bulk, moves[round], 600, results) == done);
+        assert_true(results[0] == (round < 2) && results[1]);
+    }
+    for (uint32_t player = 1; player <= 3; ++player) {
+        assert_true(gamma_busy_fields(bulk, player)
+                    == gamma_busy_fields(single, player));
+        assert_true(gamma_free_fields(bulk, player)
+                    == gamma_free_fields(single, player));
+        assert_true(gamma_golden_possible(bulk, player));
+    }
+    char *expected = gamma_board(single), *board = gamma_board(bulk);
+    assert_string_equal(board, expected);
+    free(expected);
+    free(board);
+    gamma_delete(bulk);
+    gamma_delete(single);
+}
+
+
 /** URUCHAMIANIE TESTÓW **/
 int main() {
     const struct CMUnitTest tests[] = {
@@ -737,6 +1520,22 @@ int main() {
             cmocka_unit_test(areas),
             cmocka_unit_test(tree),
             cmocka_unit_test(border),
+            cmocka_unit_test(parallel_golden),
+            cmocka_unit_test(layouts),
+            cmocka_unit_test(allocator),
+            cmocka_unit_test(file_board),
+            cmocka_unit_test(file_reopen),
+            cmocka_unit_test(board_update),
+            cmocka_unit_test(board_view),
+            cmocka_unit_test(board_write),
+            cmocka_unit_test(snapshot),
+            cmocka_unit_test(clone),
+            cmocka_unit_test(undo_redo),
+            cmocka_unit_test(legal_moves),
+            cmocka_unit_test(concurrent_reads),
+            cmocka_unit_test(multi_redeclare),
+            cmocka_unit_test(reset_pool),
+            cmocka_unit_test(move_bulk),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
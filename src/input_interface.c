@@ -48,6 +48,11 @@ void report_ok() {
 }
 
 
+int parse_line_number() {
+    return global.count_read_lines;
+}
+
+
 /** @brief Zwolnienie zasobów związanych z buforem.
  * Funkcje należy wywołać przed zakończeniem programu.
  */
@@ -57,4 +57,11 @@ void report_error();
 int parse_line(char *cmd, int params_size, uint32_t params[params_size]);
 
 
+/** @brief Numer ostatnio wczytanego wiersza.
+ * @return Numer wiersza, którego dotyczą komunikaty @ref report_ok
+ * i @ref report_error.
+ */
+int parse_line_number();
+
+
 #endif /* INPUT_INTERFACE_H */
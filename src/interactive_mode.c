@@ -346,7 +346,7 @@ static void interactive_view(struct interactive_model *m, const char *effect) {
     if (ISNULL(m) || ISNULL(effect)) {
         return;
     }
-    if (!gamma_board_buffer(m->game, m->board_buffer, m->board_buffer_size)) {
+    if (!gamma_board_update(m->game, m->board_buffer, m->board_buffer_size)) {
         exit(EXIT_FAILURE);
     }
     uint64_t busy_fields = gamma_busy_fields(m->game, m->current_player);
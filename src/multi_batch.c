@@ -0,0 +1,572 @@
+/** @file
+ * Implementacja wsadowego trybu wielu gier: polecenia wielu rozgrywek
+ * wykonywane są równolegle przez pulę wątków z podkradaniem pracy.
+ *
+ * @author Adam Rozenek <adam.rozenek@students.mimuw.edu.pl>
+ * @date 12.06.2020
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "gamma.h"
+#include "multi_batch.h"
+#include "input_interface.h"
+#include "isnull.h"
+
+
+/** Maksymalna liczba parametrów polecenia (wraz z numerem gry). */
+#define MULTI_PARAMS_SIZE 5
+
+
+/** Największa liczba wątków puli. */
+#define MULTI_MAX_THREADS 256
+
+
+/** Liczba poleceń gry wykonywanych przed oddaniem jej innym grom. */
+#define MULTI_BATCH 64
+
+
+/** Liczba wczytanych, a niewykonanych poleceń, po której wczytywanie
+ * czeka na wątki puli. */
+#define MULTI_PENDING_LIMIT ((uint64_t) 1 << 16)
+
+
+/** Początkowy rozmiar tablic kolejek i tablicy gier. */
+#define MULTI_INITIAL_SIZE 16
+
+
+/** Polecenie gry czekające na wykonanie.
+ */
+typedef struct multi_task {
+    char command; /**< Znak polecenia. */
+    int line; /**< Numer wiersza polecenia. */
+    uint32_t params[MULTI_PARAMS_SIZE]; /**< Parametry polecenia, pierwszym
+                                         * jest numer gry. */
+} multi_task_t;
+
+
+/** Gra obsługiwana w trybie wielu gier wraz z kolejką jej poleceń.
+ */
+typedef struct multi_game {
+    uint32_t id; /**< Numer gry. */
+    gamma_t *engine; /**< Silnik gry lub `NULL`, jeżeli gry jeszcze nie
+                      * utworzono. */
+    char *board; /**< Opis planszy z ostatniego polecenia `p` lub `NULL`. */
+    size_t board_size; /**< Rozmiar bufora @ref board. */
+    char *output; /**< Bufor odpowiedzi na polecenie `p`. */
+    size_t output_size; /**< Rozmiar bufora @ref output. */
+    pthread_mutex_t lock; /**< Zamek chroniący kolejkę poleceń. */
+    multi_task_t *tasks; /**< Cykliczna kolejka poleceń. */
+    size_t head; /**< Indeks pierwszego polecenia kolejki. */
+    size_t size; /**< Liczba poleceń w kolejce. */
+    size_t capacity; /**< Rozmiar tablicy poleceń. */
+    bool scheduled; /**< Informacja o tym czy gra czeka w kolejce puli albo
+                     * jest obsługiwana przez któryś z wątków. */
+    struct multi_game *next; /**< Następna gra w kubełku tablicy gier. */
+} multi_game_t;
+
+
+/** Cykliczna kolejka gier gotowych do obsługi przez jeden wątek puli.
+ * Wątek pobiera gry z początku swojej kolejki, a pozostałe wątki podkradają
+ * je z jej końca.
+ */
+typedef struct multi_queue {
+    pthread_mutex_t lock; /**< Zamek chroniący kolejkę. */
+    multi_game_t **games; /**< Tablica gier. */
+    size_t head; /**< Indeks pierwszej gry kolejki. */
+    size_t size; /**< Liczba gier w kolejce. */
+    size_t capacity; /**< Rozmiar tablicy gier. */
+} multi_queue_t;
+
+
+/** Polecenia trybu wielu gier.
+ */
+static const struct {
+    char command; /**< Znak polecenia. */
+    int param_size; /**< Liczba parametrów (wraz z numerem gry). */
+} commands[] = {
+        { 'B', 5 }, { 'm', 4 }, { 'g', 4 }, { 'b', 2 }, { 'f', 2 }, { 'q', 2 },
+        { 'p', 1 }, { 'd', 1 }
+};
+
+
+/** Stan puli wątków.
+ */
+static struct {
+    multi_queue_t queues[MULTI_MAX_THREADS]; /**< Kolejki wątków. */
+    uint32_t threads; /**< Liczba wątków. */
+    pthread_mutex_t lock; /**< Zamek chroniący liczniki puli. */
+    pthread_cond_t work; /**< Budzi wątki czekające na gry. */
+    pthread_cond_t space; /**< Budzi wczytywanie czekające na wątki. */
+    uint64_t ready; /**< Liczba gier w kolejkach. */
+    uint64_t pending; /**< Liczba niewykonanych poleceń. */
+    bool finished; /**< Informacja o tym czy wczytano całe wejście. */
+} pool = { .lock = PTHREAD_MUTEX_INITIALIZER,
+           .work = PTHREAD_COND_INITIALIZER,
+           .space = PTHREAD_COND_INITIALIZER };
+
+
+/** Tablica gier, dostępna jedynie dla wątku wczytującego polecenia.
+ */
+static struct {
+    multi_game_t **buckets; /**< Kubełki tablicy. */
+    size_t capacity; /**< Liczba kubełków. */
+    size_t size; /**< Liczba gier. */
+} table;
+
+
+/** @brief Powiększenie cyklicznej tablicy.
+ * Zajęte elementy przenoszone są na początek nowej tablicy. Jeżeli zabraknie
+ * pamięci, program kończy działanie, tak jak przy wczytywaniu wejścia.
+ * @param[in, out] array        – wskaźnik na tablicę,
+ * @param[in, out] head         – indeks pierwszego elementu,
+ * @param[in] size              – liczba elementów,
+ * @param[in, out] capacity     – rozmiar tablicy,
+ * @param[in] element_size      – rozmiar elementu w bajtach.
+ */
+static void multi_ring_grow(void **array, size_t *head, size_t size,
+                            size_t *capacity, size_t element_size) {
+    size_t new_capacity = *capacity == 0 ? MULTI_INITIAL_SIZE : *capacity * 2;
+    char *result = malloc(new_capacity * element_size);
+    if (ISNULL(result)) {
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < size; ++i) {
+        memcpy(result + i * element_size,
+               (char *) *array + (*head + i) % *capacity * element_size,
+               element_size);
+    }
+    free(*array);
+    *array = result;
+    *head = 0;
+    *capacity = new_capacity;
+}
+
+
+/** @brief Dopisanie gry do kolejki wątku puli.
+ * @param[in, out] game         – wskaźnik na grę,
+ * @param[in] worker            – numer wątku.
+ */
+static void multi_schedule(multi_game_t *game, uint32_t worker) {
+    multi_queue_t *queue = &pool.queues[worker];
+    pthread_mutex_lock(&queue->lock);
+    if (queue->size == queue->capacity) {
+        multi_ring_grow((void **) &queue->games, &queue->head, queue->size,
+                        &queue->capacity, sizeof(multi_game_t *));
+    }
+    queue->games[(queue->head + queue->size++) % queue->capacity] = game;
+    pthread_mutex_unlock(&queue->lock);
+    pthread_mutex_lock(&pool.lock);
+    pool.ready++;
+    pthread_cond_signal(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+
+/** @brief Pobranie gry do obsługi przez wątek puli.
+ * Wątek pobiera najpierw gry ze swojej kolejki, a gdy jest pusta, podkrada
+ * gry z końców kolejek pozostałych wątków.
+ * @param[in] worker            – numer wątku.
+ * @return Wskaźnik na grę lub `NULL`, jeżeli wszystkie kolejki są puste.
+ */
+static multi_game_t *multi_take(uint32_t worker) {
+    multi_game_t *game = NULL;
+    for (uint32_t i = 0; ISNULL(game) && i < pool.threads; ++i) {
+        multi_queue_t *queue = &pool.queues[(worker + i) % pool.threads];
+        pthread_mutex_lock(&queue->lock);
+        if (queue->size > 0 && i == 0) {
+            game = queue->games[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+            queue->size--;
+        } else if (queue->size > 0) {
+            game = queue->games[(queue->head + --queue->size)
+                                % queue->capacity];
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+    if (!ISNULL(game)) {
+        pthread_mutex_lock(&pool.lock);
+        pool.ready--;
+        pthread_mutex_unlock(&pool.lock);
+    }
+    return game;
+}
+
+
+/** @brief Wypisanie na wyjście diagnostyczne informacji o niepowodzeniu
+ * polecenia.
+ * @param[in] line              – numer wiersza polecenia.
+ */
+static void multi_report_error(int line) {
+    fprintf(stderr, "ERROR %d\n", line);
+}
+
+
+/** @brief Wypisanie opisu planszy dla polecenia `p`.
+ * Każdy wiersz opisu poprzedzany jest numerem gry, a całość wypisywana jest
+ * jednym wywołaniem, więc nie przeplata się z odpowiedziami innych gier.
+ * @param[in, out] game         – wskaźnik na grę.
+ * @return Wartość @p true jeżeli udało się wypisać planszę.
+ */
+static bool multi_board(multi_game_t *game) {
+    if (ISNULL(game->board)) {
+        game->board = gamma_board(game->engine);
+        game->board_size = ISNULL(game->board) ? 0 : strlen(game->board) + 1;
+    } else if (!gamma_board_update(game->engine, game->board,
+                                   game->board_size)) {
+        return false;
+    }
+    if (ISNULL(game->board)) {
+        return false;
+    }
+    char prefix[16];
+    size_t prefix_size = (size_t) snprintf(prefix, sizeof(prefix),
+                                           "%" PRIu32 " ", game->id);
+    size_t size = game->board_size - 1
+                  + (size_t) gamma_height(game->engine) * prefix_size;
+    if (size > game->output_size) {
+        free(game->output);
+        game->output = malloc(size);
+        game->output_size = ISNULL(game->output) ? 0 : size;
+        if (ISNULL(game->output)) {
+            return false;
+        }
+    }
+    char *current = game->output;
+    for (const char *row = game->board; *row != '\0';) {
+        const char *end = strchr(row, '\n') + 1;
+        memcpy(current, prefix, prefix_size);
+        memcpy(current + prefix_size, row, (size_t) (end - row));
+        current += prefix_size + (size_t) (end - row);
+        row = end;
+    }
+    fwrite(game->output, 1, (size_t) (current - game->output), stdout);
+    return true;
+}
+
+
+/** @brief Usunięcie gry wraz z jej buforami.
+ * @param[in] game              – wskaźnik na grę.
+ */
+static void multi_game_delete(multi_game_t *game) {
+    gamma_delete(game->engine);
+    free(game->board);
+    free(game->output);
+    free(game->tasks);
+    pthread_mutex_destroy(&game->lock);
+    free(game);
+}
+
+
+/** @brief Wykonanie polecenia gry.
+ * @param[in, out] game         – wskaźnik na grę,
+ * @param[in] task              – wskaźnik na polecenie.
+ */
+static void multi_task_run(multi_game_t *game, const multi_task_t *task) {
+    const uint32_t *params = task->params;
+    if (task->command == 'B') {
+        /* Gry mają własne wątki w puli, więc ich silniki nie uruchamiają
+         * kolejnych. */
+        gamma_options_t options = { .threads = 1 };
+        if (!ISNULL(game->engine)) {
+            // Gra o tym numerze już istnieje i trzeba ją najpierw usunąć.
+            multi_report_error(task->line);
+            return;
+        }
+        game->engine = gamma_new_ext(params[1], params[2], params[3],
+                                     params[4], &options);
+        if (ISNULL(game->engine)) {
+            multi_report_error(task->line);
+        } else {
+            printf("%" PRIu32 " OK %d\n", game->id, task->line);
+        }
+        return;
+    }
+    if (ISNULL(game->engine)) {
+        multi_report_error(task->line);
+        return;
+    }
+    switch (task->command) {
+        case 'm':
+            printf("%" PRIu32 " %d\n", game->id,
+                   gamma_move(game->engine, params[1], params[2], params[3]));
+            break;
+        case 'g':
+            printf("%" PRIu32 " %d\n", game->id,
+                   gamma_golden_move(game->engine, params[1], params[2],
+                                     params[3]));
+            break;
+        case 'b':
+            printf("%" PRIu32 " %" PRIu64 "\n", game->id,
+                   gamma_busy_fields(game->engine, params[1]));
+            break;
+        case 'f':
+            printf("%" PRIu32 " %" PRIu64 "\n", game->id,
+                   gamma_free_fields(game->engine, params[1]));
+            break;
+        case 'q':
+            printf("%" PRIu32 " %d\n", game->id,
+                   gamma_golden_possible(game->engine, params[1]));
+            break;
+        case 'p':
+            if (!multi_board(game)) {
+                multi_report_error(task->line);
+            }
+            break;
+        case 'd':
+            /* Gra pozostaje w tablicy gier, żeby polecenia nowej gry o tym
+             * samym numerze wykonywały się po poleceniach usuniętej. */
+            gamma_delete(game->engine);
+            free(game->board);
+            free(game->output);
+            game->engine = NULL;
+            game->board = NULL;
+            game->board_size = 0;
+            game->output = NULL;
+            game->output_size = 0;
+            printf("%" PRIu32 " OK %d\n", game->id, task->line);
+            break;
+        default:
+            break;
+    }
+}
+
+
+/** @brief Obsłużenie kolejnych poleceń gry przez wątek puli.
+ * Po @ref MULTI_BATCH poleceniach gra wraca do kolejki wątku, żeby nie
+ * zajmowała go kosztem pozostałych gier.
+ * @param[in, out] game         – wskaźnik na grę,
+ * @param[in] worker            – numer wątku.
+ */
+static void multi_game_run(multi_game_t *game, uint32_t worker) {
+    bool more = true;
+    uint64_t done = 0;
+    while (more && done < MULTI_BATCH) {
+        multi_task_t task;
+        pthread_mutex_lock(&game->lock);
+        more = game->size > 0;
+        if (more) {
+            task = game->tasks[game->head];
+            game->head = (game->head + 1) % game->capacity;
+            game->size--;
+        } else {
+            game->scheduled = false;
+        }
+        pthread_mutex_unlock(&game->lock);
+        if (more) {
+            multi_task_run(game, &task);
+            done++;
+        }
+    }
+    if (more) {
+        multi_schedule(game, worker);
+    }
+    pthread_mutex_lock(&pool.lock);
+    pool.pending -= done;
+    if (pool.pending < MULTI_PENDING_LIMIT) {
+        pthread_cond_signal(&pool.space);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+
+/** @brief Pętla wątku puli.
+ * @param[in] arg               – numer wątku (rzutowany na wskaźnik).
+ * @return Wartość `NULL`.
+ */
+static void *multi_worker(void *arg) {
+    uint32_t worker = (uint32_t) (uintptr_t) arg;
+    while (true) {
+        multi_game_t *game = multi_take(worker);
+        if (!ISNULL(game)) {
+            multi_game_run(game, worker);
+            continue;
+        }
+        pthread_mutex_lock(&pool.lock);
+        while (pool.ready == 0 && !pool.finished) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+        }
+        bool finished = pool.ready == 0 && pool.finished;
+        pthread_mutex_unlock(&pool.lock);
+        if (finished) {
+            return NULL;
+        }
+    }
+}
+
+
+/** @brief Kubełek tablicy gier.
+ * @param[in] id                – numer gry.
+ * @return Wskaźnik na początek listy gier kubełka.
+ */
+static multi_game_t **multi_bucket(uint32_t id) {
+    return &table.buckets[(id * UINT64_C(0x9e3779b97f4a7c15) >> 32)
+                          % table.capacity];
+}
+
+
+/** @brief Wyszukanie gry w tablicy gier.
+ * @param[in] id                – numer gry,
+ * @param[in] create            – informacja o tym czy należy dodać grę,
+ *                                jeżeli jej nie ma.
+ * @return Wskaźnik na grę lub `NULL`, jeżeli jej nie ma.
+ */
+static multi_game_t *multi_find(uint32_t id, bool create) {
+    if (table.capacity == 0) {
+        return NULL;
+    }
+    for (multi_game_t *game = *multi_bucket(id); !ISNULL(game);
+         game = game->next) {
+        if (game->id == id) {
+            return game;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    if (table.size == table.capacity) {
+        size_t capacity = table.capacity;
+        multi_game_t **buckets = table.buckets;
+        table.capacity *= 2;
+        table.buckets = calloc(table.capacity, sizeof(multi_game_t *));
+        if (ISNULL(table.buckets)) {
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            while (!ISNULL(buckets[i])) {
+                multi_game_t *game = buckets[i];
+                buckets[i] = game->next;
+                game->next = *multi_bucket(game->id);
+                *multi_bucket(game->id) = game;
+            }
+        }
+        free(buckets);
+    }
+    multi_game_t *game = calloc(1, sizeof(multi_game_t));
+    if (ISNULL(game)) {
+        exit(EXIT_FAILURE);
+    }
+    game->id = id;
+    pthread_mutex_init(&game->lock, NULL);
+    game->next = *multi_bucket(id);
+    *multi_bucket(id) = game;
+    table.size++;
+    return game;
+}
+
+
+/** @brief Przekazanie polecenia do kolejki gry.
+ * Jeżeli gra nie czekała na obsługę, trafia do kolejki wątku wyznaczonego
+ * przez jej numer. Gdy wątki puli nie nadążają, funkcja czeka, aż wykonają
+ * część poleceń.
+ * @param[in, out] game         – wskaźnik na grę,
+ * @param[in] task              – wskaźnik na polecenie.
+ */
+static void multi_dispatch(multi_game_t *game, const multi_task_t *task) {
+    pthread_mutex_lock(&pool.lock);
+    while (pool.pending >= MULTI_PENDING_LIMIT) {
+        pthread_cond_wait(&pool.space, &pool.lock);
+    }
+    pool.pending++;
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_lock(&game->lock);
+    if (game->size == game->capacity) {
+        multi_ring_grow((void **) &game->tasks, &game->head, game->size,
+                        &game->capacity, sizeof(multi_task_t));
+    }
+    game->tasks[(game->head + game->size++) % game->capacity] = *task;
+    bool schedule = !game->scheduled;
+    game->scheduled = true;
+    pthread_mutex_unlock(&game->lock);
+    if (schedule) {
+        multi_schedule(game, game->id % pool.threads);
+    }
+}
+
+
+/** @brief Rozpoznanie polecenia i przekazanie go do kolejki gry.
+ * @param[in] command           – znak polecenia,
+ * @param[in] param_size        – liczba parametrów polecenia,
+ * @param[in] params            – parametry polecenia.
+ */
+static void multi_command(char command, int param_size,
+                          const uint32_t params[param_size]) {
+    size_t i = 0;
+    while (i < sizeof(commands) / sizeof(commands[0])
+           && commands[i].command != command) {
+        i++;
+    }
+    if (i == sizeof(commands) / sizeof(commands[0])
+            || commands[i].param_size != param_size) {
+        report_error();
+        return;
+    }
+    multi_game_t *game = multi_find(params[0], command == 'B');
+    if (ISNULL(game)) {
+        report_error();
+        return;
+    }
+    multi_task_t task = { .command = command, .line = parse_line_number() };
+    memcpy(task.params, params, (size_t) param_size * sizeof(uint32_t));
+    multi_dispatch(game, &task);
+}
+
+
+void multi_batch_run(uint32_t threads) {
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (uint32_t) online : 1;
+    }
+    pool.threads = threads < MULTI_MAX_THREADS ? threads : MULTI_MAX_THREADS;
+    table.capacity = MULTI_INITIAL_SIZE;
+    table.buckets = calloc(table.capacity, sizeof(multi_game_t *));
+    if (ISNULL(table.buckets)) {
+        exit(EXIT_FAILURE);
+    }
+    pthread_t workers[MULTI_MAX_THREADS];
+    for (uint32_t i = 0; i < pool.threads; ++i) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+    }
+    for (uint32_t i = 0; i < pool.threads; ++i) {
+        if (pthread_create(&workers[i], NULL, multi_worker,
+                           (void *) (uintptr_t) i) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    uint32_t params[MULTI_PARAMS_SIZE];
+    char cmd;
+    int resp;
+    while ((resp = parse_line(&cmd, MULTI_PARAMS_SIZE, params)) != PARSE_END) {
+        if (resp == 0) {
+            // Polecenie bez numeru gry.
+            report_error();
+        } else if (resp > 0) {
+            multi_command(cmd, resp, params);
+        }
+    }
+    pthread_mutex_lock(&pool.lock);
+    pool.finished = true;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+    for (uint32_t i = 0; i < pool.threads; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    for (size_t i = 0; i < table.capacity; ++i) {
+        while (!ISNULL(table.buckets[i])) {
+            multi_game_t *game = table.buckets[i];
+            table.buckets[i] = game->next;
+            multi_game_delete(game);
+        }
+    }
+    for (uint32_t i = 0; i < pool.threads; ++i) {
+        free(pool.queues[i].games);
+        pthread_mutex_destroy(&pool.queues[i].lock);
+    }
+    free(table.buckets);
+    exit(EXIT_SUCCESS);
+}
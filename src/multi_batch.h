@@ -0,0 +1,28 @@
+/** @file
+ * Nagłówek modułu implementującego wsadowy tryb wielu gier programu
+ * symulującego rozgrywkę przy użyciu silnika Gamma.
+ * @author Adam Rozenek <adam.rozenek@students.mimuw.edu.pl>
+ * @date 12.06.2020
+ */
+
+#ifndef MULTIBATCH_H
+#define MULTIBATCH_H
+
+#include <stdint.h>
+
+
+/** @brief Uruchomienie i przejście do wsadowego trybu wielu gier.
+ * Każde polecenie zaczyna się numerem gry. Gra tworzona jest poleceniem
+ * `B gra width height players areas`, a usuwana poleceniem `d gra`;
+ * polecenie `B` dla istniejącej gry kończy się błędem. Pozostałe polecenia (`m`, `g`, `b`, `f`, `q`, `p`) działają jak w trybie
+ * wsadowym. Gry obsługiwane są równolegle przez pulę wątków, a polecenia
+ * jednej gry – w kolejności wczytania. Każdy wiersz odpowiedzi poprzedzony
+ * jest numerem gry, a odpowiedź na jedno polecenie wypisywana jest w całości,
+ * więc odpowiedzi każdej z gier nie zależą od liczby wątków.
+ * @param[in] threads           – liczba wątków puli lub `0` dla liczby
+ *                                dostępnych procesorów.
+ */
+void multi_batch_run(uint32_t threads);
+
+
+#endif /* MULTIBATCH_H */
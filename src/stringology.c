@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <values.h>
 #include <errno.h>
 #include "stringology.h"
@@ -29,17 +30,48 @@ int uint64_length(uint64_t number)  {
 }
 
 
-int player_write(char *buff, int n, uint32_t player, uint32_t num_len) {
-    if (player == 0) {
-        /** Jeżeli @p player jest równe `0` to znaczy że pole jest wolne
-         * i do bufora tekstowego zostaje zapisana kropka `.`.
-         */
-        return snprintf(buff, n, "%*s", num_len, ".");
-    } else {
-        /** Dla @p player większego od zera liczba zostaje zapisana do bufora.
+/** Zapis dziesiętny liczb od `00` do `99`, po dwie cyfry na liczbę. */
+static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+
+
+size_t players_write(char *buff, const uint32_t *players, uint32_t count,
+                     uint32_t num_len) {
+    if (num_len == 1) {
+        /** Identyfikatory jednocyfrowe zamieniane są na znaki bez skoków,
+         * więc kompilator wypisuje wiele pól naraz instrukcjami wektorowymi.
          */
-        return snprintf(buff, n, "%*d", num_len, player);
+        for (uint32_t i = 0; i < count; ++i) {
+            buff[i] = players[i] == 0 ? '.' : (char) ('0' + players[i]);
+        }
+        return count;
+    }
+    /** Dłuższe identyfikatory wpisywane są od końca bloku po dwie cyfry
+     * do bufora wypełnionego wcześniej spacjami.
+     */
+    size_t size = (size_t) count * num_len;
+    memset(buff, ' ', size);
+    char *end = buff;
+    for (uint32_t i = 0; i < count; ++i) {
+        end += num_len;
+        uint32_t player = players[i];
+        char *current = end;
+        if (player == 0) {
+            current[-1] = '.';
+            continue;
+        }
+        while (player >= 10) {
+            current -= 2;
+            memcpy(current, &digit_pairs[2 * (player % 100)], 2);
+            player /= 100;
+        }
+        if (player > 0) {
+            current[-1] = (char) ('0' + player);
+        }
     }
+    return size;
 }
 
 
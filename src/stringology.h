@@ -8,6 +8,7 @@
 #define STRINGOLOGY_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/param.h>
 
@@ -19,17 +20,21 @@
 int uint64_length(uint64_t number);
 
 
-/** @brief Wypisanie gracza do bufora tekstowego.
- * Funkcja wypisuje identyfikator gracza do bufora.
- * @param[out] buff          – wskaźnik na bufor tekstowy,
- * @param[in] n              – długość bufora,
- * @param[in] player         – identyfikator gracza lub @p 0 jeżeli pole jest
- *                             wolne,
+/** @brief Wypisanie graczy do bufora tekstowego.
+ * Funkcja wypisuje identyfikatory graczy do bufora, każdy dosunięty do prawej
+ * w bloku o długości @p num_len, tak jak `printf("%*d")`. Wolne pola
+ * zapisywane są jako kropka `.`. Bufor nie jest kończony znakiem `\0`.
+ * @param[out] buff          – wskaźnik na bufor tekstowy o długości co
+ *                             najmniej `count * num_len`,
+ * @param[in] players        – identyfikatory graczy lub @p 0 dla wolnych pól,
+ *                             o zapisie nie dłuższym niż @p num_len,
+ * @param[in] count          – liczba identyfikatorów,
  * @param[in] num_len        – ilość miejsca jaką ma zająć identyfikator w
  *                             buforze.
  * @return Ilość znaków wpisanych do bufora.
  */
-int player_write(char *buff, int n, uint32_t player, uint32_t num_len);
+size_t players_write(char *buff, const uint32_t *players, uint32_t count,
+                     uint32_t num_len);
 
 
 /** @brief Interpretuje ciąg znaków jako liczbę.